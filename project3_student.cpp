@@ -7,74 +7,889 @@
 #include "stemmer.h"
 #include <iomanip>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <csignal>
+#include <cstring>
 
 using namespace std;
 
+// Instrumentation: stage timers and counters, compiled in with -DTWEET_METRICS
+// and expanding to nothing otherwise. Dumped at exit and on SIGUSR1.
+enum MetricCounter {
+    COUNTER_ROWS_PARSED, COUNTER_TOKENS, COUNTER_STEMS, COUNTER_LEXICON_HITS, COUNTER_VOCAB_SIZE, COUNTER_PREDICTIONS,
+    COUNTER_QUEUE_WAITS, COUNTER_POOL_TASKS, COUNTER_POOL_STEALS, COUNTER_POOL_BUSY_MAX_US, COUNTER_POOL_BUSY_MEAN_US,
+    COUNTER_DUPLICATES, COUNTER_COUNT
+};
+enum MetricTimer {
+    TIMER_LOAD, TIMER_PARSE_CSV, TIMER_SENTIMENT, TIMER_TALKATIVE, TIMER_BIDEN, TIMER_ALIGNMENT, TIMER_ALIGNMENT_TRAIN,
+    TIMER_TOKENIZE_ALIGNMENT, TIMER_INDEX_BUILD, TIMER_PREDICT, TIMER_DEDUP,
+    TIMER_COUNT
+};
+#ifdef TWEET_METRICS
+void recordMetricTimer(MetricTimer timer, chrono::steady_clock::time_point start);
+extern atomic<long long> metricCounters[COUNTER_COUNT];
+#define METRIC_ADD(counter, amount) metricCounters[counter].fetch_add((amount), memory_order_relaxed)
+#define METRIC_SET(counter, value) metricCounters[counter].store((value), memory_order_relaxed)
+#define METRIC_TIMER_BEGIN(timer) chrono::steady_clock::time_point metricStart_##timer = chrono::steady_clock::now()
+#define METRIC_TIMER_END(timer) recordMetricTimer(timer, metricStart_##timer)
+#else
+#define METRIC_ADD(counter, amount) ((void)sizeof(amount))
+#define METRIC_SET(counter, value) ((void)sizeof(value))
+#define METRIC_TIMER_BEGIN(timer) ((void)0)
+#define METRIC_TIMER_END(timer) ((void)0)
+#endif
+bool configureMetrics(string format, string path);
+
+// Report output formats (--format); every report writes into one buffer
+enum ReportFormat { REPORT_TABLE, REPORT_CSV, REPORT_JSON, REPORT_BINARY };
+
+// Run plan: the reports a run produces (--run), as a bit set. "all" is the
+// four original reports; the metadata reports never read tweet text.
+enum RunAnalysis {
+    RUN_SENTIMENT = 1, RUN_TALKATIVE = 2, RUN_BIDEN = 4, RUN_ALIGNMENT = 8, RUN_ALL = 15,
+    RUN_COUNTS = 16, RUN_DATES = 32, RUN_SENATORS = 64
+};
+
+// Column projection for the CSV loader, as a bit set of the columns to keep
+enum CsvColumn { COL_ID = 1, COL_USER = 2, COL_CREATED = 4, COL_SENATOR = 8, COL_TEXT = 16, COL_ALL = 31 };
+
+// Duplicate removal (--dedup) and which row of a duplicate group survives (--dedup-keep)
+enum DedupMode { DEDUP_NONE, DEDUP_EXACT, DEDUP_NEAR };
+enum DedupKeep { KEEP_FIRST, KEEP_LAST, KEEP_LONGEST };
+
 // Function Prototypes
 vector<vector<string>> read_tweets_csv_file();
 vector<string> readEmotionFile(string path);
 vector<string> getUniqueSenators(const vector<vector<string>>& tweets);
+void internSenators(const vector<vector<string>>& tweets, vector<string>& senatorNames, vector<int>& senatorTable);
+vector<string> sortedSenators(const vector<string>& senatorNames);
 string getParty(string senator);
-void calculateSentiment(const vector<vector<string>>& tweets, const vector<string>& senators, const vector<string>& positiveWords, const vector<string>& negativeWords);
-void findMostTalkative(const vector<vector<string>>& tweets, const vector<string>& senators);
-void analyzeBidenSentiment(const vector<vector<string>>& tweets, const vector<string>& positiveWords, const vector<string>& negativeWords);
-void analyzePoliticalAlignment(const vector<vector<string>>& tweets, const vector<string>& senators);
-
-int main() {
-    cout << "Reading data files..." << endl;
-    vector<vector<string>> tweets = read_tweets_csv_file();
-    vector<string> positiveWords = readEmotionFile("positive-words.txt");
-    vector<string> negativeWords = readEmotionFile("negative-words.txt");
-    vector<string> senators = getUniqueSenators(tweets);
-
-    cout << "Data loaded." << endl;
-    cout << "Tweets: " << tweets.size() << endl;
-    cout << "Positive Words: " << positiveWords.size() << endl;
-    cout << "Negative Words: " << negativeWords.size() << endl;
-    cout << "Senators: " << senators.size() << endl;
-    cout << endl;
+void calculateSentiment(const vector<vector<string>>& tweets, const vector<string>& senators, const vector<string>& lexiconTerms,
+                        const vector<double>& lexiconScores, const vector<string>& negators, int negationWindow,
+                        const vector<unsigned long long>& stopFilter, ostream& out, ReportFormat format);
+void findMostTalkative(const vector<vector<string>>& tweets, const vector<string>& senators, ostream& out, ReportFormat format);
+void aggregateSenatorSentiment(const vector<vector<string>>& tweets, const vector<string>& senators, const vector<string>& lexiconTerms,
+                               const vector<double>& lexiconScores, const vector<string>& negators, int negationWindow,
+                               const vector<unsigned long long>& stopFilter, vector<int>& senTweets, vector<int>& senWords,
+                               vector<double>& senPositive, vector<double>& senNegative, vector<int>& senEmojiPositive,
+                               vector<int>& senEmojiNegative);
+void reportSentiment(const vector<string>& senators, const vector<int>& senWords, const vector<double>& senPositive,
+                     const vector<double>& senNegative, const vector<int>& senEmojiPositive, const vector<int>& senEmojiNegative,
+                     ostream& out, ReportFormat format);
+void countSenatorWords(const vector<vector<string>>& tweets, const vector<string>& senators, vector<int>& senTweets, vector<int>& senWords);
+void reportMostTalkative(const vector<string>& senators, const vector<int>& senTweets, const vector<int>& senWords,
+                         ostream& out, ReportFormat format);
+void aggregateBidenSentiment(const vector<vector<string>>& tweets, const vector<string>& lexiconTerms, const vector<double>& lexiconScores,
+                             const vector<string>& negators, int negationWindow, const vector<unsigned long long>& stopFilter,
+                             int& bidenTweetCount, int& totalWords, double& posCount, double& negCount);
+void reportBidenSentiment(int bidenTweetCount, int totalWords, double posCount, double negCount, ostream& out, ReportFormat format);
+void analyzeBidenSentiment(const vector<vector<string>>& tweets, const vector<string>& lexiconTerms, const vector<double>& lexiconScores,
+                           const vector<string>& negators, int negationWindow, const vector<unsigned long long>& stopFilter,
+                           ostream& out, ReportFormat format);
+void analyzePoliticalAlignment(const vector<vector<string>>& tweets, const vector<string>& senators, const vector<string>& negators, int negationWindow,
+                               const vector<unsigned long long>& stopFilter, ostream& out, ReportFormat format, int maxNgram = 1);
+
+// Metadata report prototypes
+void reportTweetCounts(const vector<vector<string>>& tweets, const vector<string>& senators, ostream& out, ReportFormat format);
+void reportDateHistogram(const vector<vector<string>>& tweets, ostream& out, ReportFormat format);
+void reportSenatorList(const vector<string>& senators, ostream& out, ReportFormat format);
+
+// Report writer prototypes
+bool parseReportFormat(const string& name, ReportFormat& format);
+bool parseRunPlan(const string& list, int& plan);
+void writeReportSection(ostream& out, ReportFormat format, const string& section, const vector<string>& columns,
+                        const string& types, const vector<vector<string>>& rows);
+string formatReportNumber(double value, int precision);
+
+// Stop-word filter prototypes
+vector<unsigned long long> defaultStopFilter();
+vector<unsigned long long> buildStopFilter(const vector<string>& words);
+inline bool isStopWord(unsigned long long hash, const vector<unsigned long long>& stopFilter);
+
+// Negation settings and prototypes
+const int MAX_NEGATION_WINDOW = 31;
+const int DEFAULT_NEGATION_WINDOW = 2;
+inline bool isTokenSpace(char c);
+constexpr bool isAsciiLetter(char c);
+unsigned long long termHash(const string& word);
+
+// UTF-8 normalization prototypes
+inline size_t asciiPrefixLength(const char* p, size_t n);
+string normalizeUtf8(const string& text);
+string stemToken(const string& word);
+vector<string> defaultNegators();
+vector<unsigned long long> negatorHashes(const vector<string>& negators);
+void scoreTextSentiment(const string& text, const vector<unsigned long long>& trieKeys, const vector<int>& trieChild,
+                        const vector<double>& nodeWeights, const vector<unsigned long long>& negHashes, int window,
+                        const vector<unsigned long long>& stopFilter, int& words, double& positive, double& negative,
+                        int& emojiPositive, int& emojiNegative);
+long long scoreLexiconMatches(const vector<unsigned long long>& stemHashes, const vector<char>& negatorFlags,
+                              const vector<unsigned long long>& trieKeys, const vector<int>& trieChild,
+                              const vector<double>& nodeWeights, int window, double& positive, double& negative);
+
+// Emoji channel prototypes
+constexpr int emojiPolarity(unsigned int cp);
+void countEmoji(const string& word, int& positive, int& negative);
+
+// Weighted lexicon prototypes
+unsigned long long fnv1aHash(const string& buf, size_t begin, size_t end);
+bool readWeightedLexicon(string path, vector<string>& terms, vector<double>& scores);
+void lexiconFromWordLists(const vector<string>& positiveWords, const vector<string>& negativeWords,
+                          vector<string>& terms, vector<double>& scores);
+void compileLexicon(const vector<string>& terms, const vector<double>& scores, vector<unsigned long long>& trieKeys,
+                    vector<int>& trieChild, vector<double>& nodeWeights);
+inline int lexiconStep(int node, unsigned long long stemHash, const vector<unsigned long long>& trieKeys, const vector<int>& trieChild);
+string formatReportScore(double value);
+
+void trainAlignmentModel(const vector<vector<string>>& tweets, const vector<unsigned long long>& stopFilter,
+                         vector<string>& keyTerms, vector<string>& keyTermParty, int maxNgram = 1);
+void trainAlignmentModel(const vector<vector<string>>& tweets, const vector<unsigned long long>& stopFilter,
+                         vector<string>& keyTerms, vector<string>& keyTermParty, int maxNgram,
+                         vector<string>& vocab, vector<int>& repCounts, vector<int>& demCounts);
+void selectKeyTerms(const vector<int>& candRep, const vector<int>& candDem, vector<int>& picks, vector<string>& pickParty);
+void keyTermsFromCounts(const vector<string>& vocab, const vector<int>& repCounts, const vector<int>& demCounts,
+                        vector<string>& keyTerms, vector<string>& keyTermParty);
+void reportKeyTerms(const vector<string>& keyTerms, const vector<string>& keyTermParty, ostream& out, ReportFormat format);
+void printAlignmentAccuracy(const vector<string>& senators, const vector<int>& senCorrect, const vector<int>& senTotal,
+                            int correctPredictions, int totalPredictions, ostream& out, ReportFormat format);
+
+// Alignment scorer prototypes
+const int MAX_NGRAM = 3;
+const size_t NGRAM_TABLE_SLOTS = 1 << 20;
+inline unsigned long long ngramHash(unsigned long long prefix, unsigned long long token);
+unsigned long long phraseHash(const string& phrase);
+void buildAlignmentScorer(const vector<string>& terms, const vector<double>& weights, const vector<string>& negators,
+                          vector<unsigned long long>& scorerKeys, vector<double>& scorerWeights, vector<unsigned char>& scorerFlags);
+int predictWithScorer(const string& text, const vector<unsigned long long>& scorerKeys,
+                      const vector<double>& scorerWeights, const vector<unsigned char>& scorerFlags, int negationWindow);
+string predictionParty(int prediction);
+vector<double> keyTermWeights(const vector<string>& keyTermParty);
+bool saveAlignmentModel(string path, const vector<string>& terms, const vector<double>& weights, const vector<string>& negators,
+                        int negationWindow);
+bool loadAlignmentModel(string path, vector<string>& terms, vector<double>& weights, vector<string>& negators, int& negationWindow);
+void runAlignmentPredictor(const vector<unsigned long long>& scorerKeys, const vector<double>& scorerWeights,
+                           const vector<unsigned char>& scorerFlags, int negationWindow, istream& in, ostream& out);
+
+// Partial aggregate prototypes
+bool writeAnalysisPartial(string path, long long tweetCount, int positiveCount, int negativeCount, int lexiconEntries,
+                          const vector<string>& senators, const vector<int>& senTweets, const vector<int>& senWords,
+                          const vector<double>& senPositive, const vector<double>& senNegative, const vector<int>& senEmojiPositive,
+                          const vector<int>& senEmojiNegative, const vector<int>& senTalkWords, int bidenTweets, int bidenWords,
+                          double bidenPositive, double bidenNegative, const vector<string>& vocab, const vector<int>& repCounts,
+                          const vector<int>& demCounts);
+bool emitAnalysisPartial(string path, const vector<vector<string>>& tweets, const vector<string>& senators, int positiveCount,
+                         int negativeCount, int lexiconEntries, const vector<string>& lexiconTerms, const vector<double>& lexiconScores,
+                         const vector<string>& negators, int negationWindow, const vector<unsigned long long>& sentimentStopFilter,
+                         const vector<unsigned long long>& stopFilter);
+bool mergeAnalysisPartial(string path, int& partials, long long& tweetCount, int& positiveCount, int& negativeCount,
+                          int& lexiconEntries, vector<string>& senatorNames, vector<int>& senatorTable, vector<int>& senTweets,
+                          vector<int>& senWords, vector<double>& senPositive, vector<double>& senNegative, vector<int>& senEmojiPositive,
+                          vector<int>& senEmojiNegative, vector<int>& senTalkWords, int& bidenTweets, int& bidenWords,
+                          double& bidenPositive, double& bidenNegative, vector<string>& vocab, vector<int>& vocabTable,
+                          vector<int>& repCounts, vector<int>& demCounts);
+int runPartialMerge(const vector<string>& paths, int runPlan, ReportFormat format, const string& emitPath, const string& modelPath,
+                    const vector<string>& negators, int negationWindow, ostream& out);
+void sortSenatorTotals(vector<string>& senatorNames, vector<int>& senatorTable, const vector<string>& senators, vector<int>& senTweets,
+                       vector<int>& senWords, vector<double>& senPositive, vector<double>& senNegative, vector<int>& senEmojiPositive,
+                       vector<int>& senEmojiNegative, vector<int>& senTalkWords);
+
+// Streamed load prototypes
+const size_t PIPELINE_BLOCK_BYTES = 1 << 20;
+const size_t PIPELINE_BATCH_ROWS = 512;
+const size_t PIPELINE_DEPTH = 8;  // slots per ring, a power of two
+size_t ringReserve(const atomic<size_t>& head, const atomic<size_t>& tail);
+void ringPublish(atomic<size_t>& tail);
+bool ringAcquire(const atomic<size_t>& head, const atomic<size_t>& tail, const atomic<bool>& done, size_t& slot);
+void ringRelease(atomic<size_t>& head);
+void streamTweetsCsv(string path, bool retainRows, const vector<string>& lexiconTerms, const vector<double>& lexiconScores,
+                     const vector<string>& negators, int negationWindow, const vector<unsigned long long>& stopFilter,
+                     vector<vector<string>>& tweets, long long& tweetCount, vector<string>& senatorNames, vector<int>& senatorTable,
+                     vector<int>& senTweets, vector<int>& senWords, vector<double>& senPositive, vector<double>& senNegative,
+                     vector<int>& senEmojiPositive, vector<int>& senEmojiNegative, vector<int>& senTalkWords, int& bidenTweets,
+                     int& bidenWords, double& bidenPositive, double& bidenNegative);
+
+// Duplicate removal prototypes
+const int MINHASH_SIZE = 64;
+const size_t SHINGLE_WORDS = 3;
+const double DEFAULT_DEDUP_THRESHOLD = 0.8;
+vector<string> dedupTokens(const string& text);
+bool sameDedupText(const string& text, const vector<string>& tokens, const string& other);
+int findKey(const vector<unsigned long long>& keys, const vector<int>& values, unsigned long long key);
+void insertKey(vector<unsigned long long>& keys, vector<int>& values, size_t& used, unsigned long long key, int value);
+void minHashSignature(const vector<string>& tokens, unsigned int* signature);
+int minHashBandRows(double threshold);
+vector<vector<string>> deduplicateTweets(const vector<vector<string>>& tweets, DedupMode mode, DedupKeep keep, double threshold,
+                                         long long& exactRemoved, long long& nearRemoved);
+
+// Work-stealing pool prototypes
+const int POOL_TASK_ROWS = 256;
+int poolWorkers(int taskCount);
+int poolTake(atomic<unsigned long long>& range, bool fromBack);
+
+// Per-senator accumulator prototypes
+const size_t CACHE_LINE_BYTES = 64;
+size_t cacheLinePadded(size_t count, size_t elementBytes);
+size_t cacheLineOffset(const void* data, size_t elementBytes);
+template <typename T>
+size_t initAccumulators(vector<T>& table, int workers, int columns, size_t senators);
+template <typename T>
+T* accumulatorColumn(vector<T>& table, size_t base, int worker, int column, int columns, size_t senators);
+template <typename T>
+void mergeAccumulators(vector<T>& table, size_t base, int workers, int columns, size_t senators);
+void benchAccumulators(const vector<vector<string>>& tweets, const vector<string>& senators, int maxThreads, long long rows,
+                       ostream& out);
+// Log-odds alignment model prototypes
+void trainLogOddsModel(const vector<vector<string>>& tweets, const vector<unsigned long long>& stopFilter, vector<string>& vocab,
+                       vector<double>& weights, double& prior);
+void buildVocabIndex(const vector<string>& vocab, vector<unsigned long long>& vocabKeys, vector<int>& vocabIds);
+int predictLogOdds(const string& text, const vector<unsigned long long>& vocabKeys, const vector<int>& vocabIds,
+                   const vector<double>& weights, double prior, const vector<unsigned long long>& negHashes, int negationWindow);
+void analyzeAlignmentLogOdds(const vector<vector<string>>& tweets, const vector<string>& senators, const vector<string>& negators,
+                             int negationWindow, const vector<unsigned long long>& stopFilter, ostream& out, ReportFormat format);
+
+// Vocabulary sketch prototypes
+const int HLL_PRECISION = 12;
+const size_t HLL_REGISTERS = size_t(1) << HLL_PRECISION;
+const int HLL_FIXED_GROUPS = 3;  // all, Republican, Democrat; then one per senator
+const int CMS_DEPTH = 4;
+const size_t CMS_WIDTH = size_t(1) << 16;
+const int SPACE_SAVING_CAPACITY = 512;
+const size_t SPACE_SAVING_TABLE = 2048;
+inline unsigned long long sketchHash(unsigned long long hash);
+void hllAdd(vector<atomic<unsigned char>>& registers, size_t group, unsigned long long hash);
+double hllEstimate(const vector<atomic<unsigned char>>& registers, size_t group);
+void cmsAdd(vector<atomic<unsigned int>>& cms, int side, unsigned long long hash);
+unsigned int cmsEstimate(const vector<atomic<unsigned int>>& cms, int side, unsigned long long hash);
+void spaceSavingOffer(vector<unsigned long long>& ssKeys, vector<long long>& ssCounts, vector<long long>& ssErrors, vector<string>& ssTerms,
+                      vector<int>& ssTable, vector<int>& ssSize, int side, unsigned long long key, const string& term,
+                      long long count, long long error);
+void initSharedSketches(size_t senatorCount, vector<atomic<unsigned char>>& hll, vector<atomic<unsigned int>>& cms);
+void initVocabSketch(vector<unsigned long long>& ssKeys, vector<long long>& ssCounts, vector<long long>& ssErrors, vector<string>& ssTerms,
+                     vector<int>& ssTable, vector<int>& ssSize, vector<long long>& sideTokens);
+void buildVocabSketch(const vector<vector<string>>& tweets, size_t rowBegin, size_t rowEnd, const vector<string>& senators,
+                      const vector<unsigned long long>& stopFilter, vector<atomic<unsigned char>>& hll, vector<atomic<unsigned int>>& cms,
+                      vector<unsigned long long>& ssKeys, vector<long long>& ssCounts, vector<long long>& ssErrors, vector<string>& ssTerms,
+                      vector<int>& ssTable, vector<int>& ssSize, vector<long long>& sideTokens);
+void mergeVocabSketch(vector<unsigned long long>& ssKeys, vector<long long>& ssCounts, vector<long long>& ssErrors, vector<string>& ssTerms,
+                      vector<int>& ssTable, vector<int>& ssSize, vector<long long>& sideTokens,
+                      const vector<unsigned long long>& srcKeys, const vector<long long>& srcCounts, const vector<long long>& srcErrors,
+                      const vector<string>& srcTerms, const vector<int>& srcSize, const vector<long long>& srcSideTokens);
+void analyzeAlignmentSketch(const vector<vector<string>>& tweets, const vector<string>& senators, const vector<string>& negators,
+                            int negationWindow, const vector<unsigned long long>& stopFilter, ostream& out, ReportFormat format);
+
+// Cross-validation prototypes
+void tokenizeForAlignment(const vector<vector<string>>& tweets, const vector<unsigned long long>& stopFilter,
+                          const vector<unsigned long long>& negHashes, int negationWindow, vector<string>& vocab,
+                          vector<int>& tokenOffsets, vector<int>& tokenIds, vector<char>& tokenNegated, vector<char>& tweetRepublican);
+void computeLogOddsWeights(const vector<long long>& repCounts, const vector<long long>& demCounts,
+                           long long repTweets, long long demTweets, vector<double>& weights, double& prior);
+void crossValidateAlignment(const vector<vector<string>>& tweets, const vector<string>& senators, const vector<string>& negators,
+                            int negationWindow, const vector<unsigned long long>& stopFilter, int folds);
+
+// Binary corpus format prototypes
+void appendU32(string& buf, unsigned int value);
+void appendU64(string& buf, unsigned long long value);
+vector<vector<string>> read_tweets_csv_file(string path, int columns = COL_ALL);
+vector<vector<string>> read_tweets_csv_file(string path, int columns, vector<string>& senatorNames, vector<int>& senatorTable);
+vector<vector<string>> parseTweetsCsv(istream& fin, int columns = COL_ALL);
+vector<vector<string>> parseTweetsCsv(istream& fin, int columns, vector<string>& senatorNames, vector<int>& senatorTable);
+int internString(const string& str, vector<string>& strings, vector<int>& table);
+long long parseIsoTimestamp(const string& iso);
+string formatIsoTimestamp(long long epochMillis);
+void formatIsoTimestamp(long long epochMillis, char* out);
+bool writeBinaryCorpus(const vector<vector<string>>& tweets, string path);
+vector<vector<string>> readBinaryCorpus(string path, int columns, vector<string>& senatorNames, vector<int>& senatorTable);
+
+// Compressed corpus storage prototypes
+string lzCompress(const string& input);
+bool lzDecompress(const string& input, size_t rawSize, string& output);
+long long parseDateArgument(const string& date, bool endOfDay);
+vector<vector<string>> filterTweetRows(const vector<vector<string>>& tweets, const string& senatorFilter, long long fromMillis,
+                                       long long toMillis);
+bool writeCompressedCorpus(const vector<vector<string>>& tweets, string path, int rowsPerBlock);
+vector<vector<string>> readCompressedCorpus(string path, string senatorFilter, long long fromMillis, long long toMillis);
+
+// Inverted index prototypes
+string cleanWord(const string& word);
+void buildInvertedIndex(const vector<vector<string>>& tweets, const vector<string>& lexiconTerms, const vector<double>& lexiconScores,
+                        const vector<string>& negators, int negationWindow, const vector<unsigned long long>& sentimentStopFilter,
+                        vector<string>& stems, vector<int>& stemTable, vector<string>& postings, vector<int>& postingCounts,
+                        vector<int>& tweetWords, vector<double>& tweetPositive, vector<double>& tweetNegative);
+vector<int> intersectPostings(const vector<string>& terms, const vector<string>& stems, const vector<int>& stemTable,
+                              const vector<string>& postings, const vector<int>& postingCounts, long long& postingsDecoded);
+void queryTermSentiment(const vector<string>& terms, const vector<string>& stems, const vector<int>& stemTable,
+                        const vector<string>& postings, const vector<int>& postingCounts,
+                        const vector<int>& tweetWords, const vector<double>& tweetPositive, const vector<double>& tweetNegative);
+
+// Query server prototypes
+void runQueryServer(const vector<vector<string>>& tweets, const vector<string>& lexiconTerms, const vector<double>& lexiconScores,
+                    const vector<string>& negators, int negationWindow, const vector<unsigned long long>& sentimentStopFilter,
+                    const vector<unsigned long long>& stopFilter, int maxNgram, istream& in, ostream& out);
+
+// Benchmark prototypes
+long long peakRssKb();
+void runBenchmarks(const vector<vector<string>>& tweets, const vector<string>& lexiconTerms, const vector<double>& lexiconScores,
+                   const vector<string>& negators, int negationWindow, const vector<unsigned long long>& sentimentStopFilter,
+                   const vector<unsigned long long>& stopFilter, const vector<long long>& sizes, ostream& out);
+
+int main(int argc, char* argv[]) {
+    // Metrics output: --metrics json|prometheus, --metrics-out <file> (default stderr)
+    string metricsFormat, metricsPath;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (string(argv[i]) == "--metrics") metricsFormat = argv[i + 1];
+        if (string(argv[i]) == "--metrics-out") metricsPath = argv[i + 1];
+    }
+    if ((!metricsFormat.empty() || !metricsPath.empty()) && !configureMetrics(metricsFormat, metricsPath)) return 1;
+
+    // Convert mode: parse the CSV once and write the binary corpus
+    // Usage: --convert [tweets.csv] [tweets.bin]
+    if (argc >= 2 && string(argv[1]) == "--convert") {
+        string csvPath = (argc >= 3) ? argv[2] : "tweets.csv";
+        string binPath = (argc >= 4) ? argv[3] : "tweets.bin";
+        vector<vector<string>> rows = read_tweets_csv_file(csvPath);
+        if (rows.empty() || !writeBinaryCorpus(rows, binPath)) {
+            return 1;
+        }
+        cout << "Wrote " << rows.size() << " tweets to " << binPath << endl;
+        return 0;
+    }
+
+    // Compress mode: write the block-compressed corpus
+    // Usage: --compress [tweets.csv] [tweets.twbz] [rowsPerBlock]
+    if (argc >= 2 && string(argv[1]) == "--compress") {
+        string csvPath = (argc >= 3) ? argv[2] : "tweets.csv";
+        string outPath = (argc >= 4) ? argv[3] : "tweets.twbz";
+        int rowsPerBlock = (argc >= 5) ? atoi(argv[4]) : 256;
+        vector<vector<string>> rows = read_tweets_csv_file(csvPath);
+        if (rows.empty() || rowsPerBlock <= 0 || !writeCompressedCorpus(rows, outPath, rowsPerBlock)) {
+            return 1;
+        }
+        cout << "Wrote " << rows.size() << " tweets to " << outPath << endl;
+        return 0;
+    }
+
+    // Negation settings shared by lexicon sentiment and alignment scoring,
+    // and the longest phrase the alignment model may pick as a key term
+    // Usage: --negation-window <0..31> (0 disables), --negators <word file>, --ngram-max <1..3>,
+    //        --stop-words <word file>, --sentiment-stop-words (also skip stop words in lexicon lookups)
+    vector<string> negators = defaultNegators();
+    int negationWindow = DEFAULT_NEGATION_WINDOW;
+    int maxNgram = 1;
+    vector<unsigned long long> stopFilter = defaultStopFilter();
+    bool sentimentStopWords = false;
+    for (int i = 1; i + 1 < argc; ++i) {
+        string flag = argv[i];
+        if (flag == "--negation-window") {
+            negationWindow = atoi(argv[i + 1]);
+            if (negationWindow < 0 || negationWindow > MAX_NEGATION_WINDOW) {
+                cerr << "Error: --negation-window must be between 0 and " << MAX_NEGATION_WINDOW << endl;
+                return 1;
+            }
+        } else if (flag == "--negators") {
+            negators = readEmotionFile(argv[i + 1]);
+        } else if (flag == "--stop-words") {
+            stopFilter = buildStopFilter(readEmotionFile(argv[i + 1]));
+        } else if (flag == "--ngram-max") {
+            maxNgram = atoi(argv[i + 1]);
+            if (maxNgram < 1 || maxNgram > MAX_NGRAM) {
+                cerr << "Error: --ngram-max must be between 1 and " << MAX_NGRAM << endl;
+                return 1;
+            }
+        }
+    }
+    // Sentiment keeps stop words by default: "will" and "us" stem to lexicon entries
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "--sentiment-stop-words") sentimentStopWords = true;
+    }
+    vector<unsigned long long> sentimentStopFilter = sentimentStopWords ? stopFilter : buildStopFilter(vector<string>());
+
+    // Duplicate removal ahead of every analysis
+    // Usage: --dedup exact|near, --dedup-keep first|last|longest (default first),
+    //        --dedup-threshold <0..1> (near duplicates' estimated Jaccard similarity, default 0.8)
+    DedupMode dedupMode = DEDUP_NONE;
+    DedupKeep dedupKeep = KEEP_FIRST;
+    double dedupThreshold = DEFAULT_DEDUP_THRESHOLD;
+    for (int i = 1; i + 1 < argc; ++i) {
+        string flag = argv[i];
+        string value = argv[i + 1];
+        if (flag == "--dedup") {
+            if (value == "exact") dedupMode = DEDUP_EXACT;
+            else if (value == "near") dedupMode = DEDUP_NEAR;
+            else {
+                cerr << "Error: --dedup expects exact or near" << endl;
+                return 1;
+            }
+        } else if (flag == "--dedup-keep") {
+            if (value == "first") dedupKeep = KEEP_FIRST;
+            else if (value == "last") dedupKeep = KEEP_LAST;
+            else if (value == "longest") dedupKeep = KEEP_LONGEST;
+            else {
+                cerr << "Error: --dedup-keep expects first, last or longest" << endl;
+                return 1;
+            }
+        } else if (flag == "--dedup-threshold") {
+            dedupThreshold = atof(value.c_str());
+            if (dedupThreshold <= 0.0 || dedupThreshold > 1.0) {
+                cerr << "Error: --dedup-threshold must be above 0 and at most 1" << endl;
+                return 1;
+            }
+        }
+    }
+
+    // Report format: --format table|csv|json|binary (default table)
+    ReportFormat reportFormat = REPORT_TABLE;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (string(argv[i]) == "--format" && !parseReportFormat(argv[i + 1], reportFormat)) {
+            cerr << "Error: --format expects table, csv, json or binary" << endl;
+            return 1;
+        }
+    }
+
+    // Run plan and input paths; lexicons are only read when a selected report
+    // or service mode uses them
+    // Usage: --run sentiment,talkative,biden,alignment,counts,dates,senators (default all = the first four),
+    //        --tweets <csv>, --binary <file from --convert>, --compressed <file from --compress>,
+    //        --senator NAME, --from YYYY-MM-DD, --to YYYY-MM-DD (row filters for every loader;
+    //        --compressed also skips the blocks they rule out),
+    //        --positive <word file>, --negative <word file>,
+    //        --lexicon <term<TAB>score file> (replaces the word lists for Part 1 and Biden)
+    int runPlan = RUN_ALL;
+    string tweetsPath = "tweets.csv";
+    string binaryPath, compressedPath;
+    string senatorFilter;
+    long long fromMillis = -1;
+    long long toMillis = -1;
+    string positivePath = "positive-words.txt";
+    string negativePath = "negative-words.txt";
+    string lexiconPath;
+    bool serviceMode = false;
+    bool modelMode = false;
+    for (int i = 1; i < argc; ++i) {
+        string flag = argv[i];
+        if (flag == "--query" || flag == "--serve" || flag == "--bench" || flag == "--emit-partial" || flag == "--bench-accumulators") {
+            serviceMode = true;
+        }
+        if (flag == "--save-model" || flag == "--cv") modelMode = true;
+        if (i + 1 >= argc) continue;
+        if (flag == "--run" && !parseRunPlan(argv[i + 1], runPlan)) {
+            cerr << "Error: --run expects a comma-separated list of sentiment, talkative, biden, alignment, counts, dates, senators" << endl;
+            return 1;
+        }
+        if (flag == "--tweets") tweetsPath = argv[i + 1];
+        if (flag == "--binary") binaryPath = argv[i + 1];
+        if (flag == "--compressed") compressedPath = argv[i + 1];
+        if (flag == "--senator") senatorFilter = argv[i + 1];
+        if ((flag == "--from" && (fromMillis = parseDateArgument(argv[i + 1], false)) < 0) ||
+            (flag == "--to" && (toMillis = parseDateArgument(argv[i + 1], true)) < 0)) {
+            return 1;
+        }
+        if (flag == "--positive") positivePath = argv[i + 1];
+        if (flag == "--negative") negativePath = argv[i + 1];
+        if (flag == "--lexicon") lexiconPath = argv[i + 1];
+    }
+    bool needLexicons = serviceMode || (runPlan & (RUN_SENTIMENT | RUN_BIDEN)) != 0;
+    bool needText = serviceMode || modelMode || dedupMode != DEDUP_NONE || (runPlan & RUN_ALL) != 0;
+
+    // Predict mode with a saved model: no corpus is loaded at all
+    // Usage: --predict --model <file>   (texts on stdin, one per line)
+    for (int i = 1; i + 2 < argc; ++i) {
+        if (string(argv[i]) == "--predict" && string(argv[i + 1]) == "--model") {
+            vector<string> terms, modelNegators;
+            vector<double> weights;
+            int modelWindow = DEFAULT_NEGATION_WINDOW;
+            if (!loadAlignmentModel(argv[i + 2], terms, weights, modelNegators, modelWindow)) return 1;
+            vector<unsigned long long> scorerKeys;
+            vector<double> scorerWeights;
+            vector<unsigned char> scorerFlags;
+            buildAlignmentScorer(terms, weights, modelNegators, scorerKeys, scorerWeights, scorerFlags);
+            runAlignmentPredictor(scorerKeys, scorerWeights, scorerFlags, modelWindow, cin, cout);
+            return 0;
+        }
+    }
+
+    // Merge mode: partials written by --emit-partial, in corpus order
+    // Usage: --merge <file> [file...] [--emit-partial <file> | --save-model <file>]
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) != "--merge") continue;
+        vector<string> paths;
+        for (int j = i + 1; j < argc && string(argv[j]).compare(0, 2, "--") != 0; ++j) paths.push_back(argv[j]);
+        if (paths.empty()) {
+            cerr << "Error: --merge expects at least one partial file" << endl;
+            return 1;
+        }
+        string emitPath, modelPath;
+        for (int j = 1; j + 1 < argc; ++j) {
+            if (string(argv[j]) == "--emit-partial") emitPath = argv[j + 1];
+            if (string(argv[j]) == "--save-model") modelPath = argv[j + 1];
+        }
+        return runPartialMerge(paths, runPlan, reportFormat, emitPath, modelPath, negators, negationWindow, cout);
+    }
+
+    // Streamed load: Part 1, talkative and Biden are scored while the CSV is read
+    // Usage: --pipeline
+    bool pipelined = false;
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "--pipeline") pipelined = true;
+    }
+    bool rowFilters = !senatorFilter.empty() || fromMillis >= 0 || toMillis >= 0;
+    pipelined = pipelined && !serviceMode && !modelMode && dedupMode == DEDUP_NONE && (runPlan & (RUN_SENTIMENT | RUN_TALKATIVE | RUN_BIDEN)) != 0 &&
+                compressedPath.empty() && binaryPath.empty() && !rowFilters;
+
+    if (reportFormat == REPORT_TABLE) cout << "Reading data files..." << endl;
+    METRIC_TIMER_BEGIN(TIMER_LOAD);
+    vector<string> positiveWords, negativeWords;
+    if (needLexicons) {
+        positiveWords = readEmotionFile(positivePath);
+        negativeWords = readEmotionFile(negativePath);
+    }
+    // Sentiment lexicon: the weighted file if given, else the word lists at +1 / -1
+    vector<string> lexiconTerms;
+    vector<double> lexiconScores;
+    if (!lexiconPath.empty()) {
+        if (!readWeightedLexicon(lexiconPath, lexiconTerms, lexiconScores)) return 1;
+    } else {
+        lexiconFromWordLists(positiveWords, negativeWords, lexiconTerms, lexiconScores);
+    }
+    vector<vector<string>> tweets;
+    long long tweetCount = 0;
+    vector<string> senatorNames;
+    vector<int> senatorTable;
+    // Aggregates scored during a streamed load, per senator id until sorted below
+    vector<int> senTweets, senWords, senEmojiPositive, senEmojiNegative, senTalkWords;
+    vector<double> senPositive, senNegative;
+    int bidenTweets = 0, bidenWords = 0;
+    double bidenPositive = 0, bidenNegative = 0;
+    if (!compressedPath.empty()) {
+        // Load only the blocks that can contain the requested senator / dates
+        tweets = readCompressedCorpus(compressedPath, senatorFilter, fromMillis, toMillis);
+        internSenators(tweets, senatorNames, senatorTable);
+    } else if (!binaryPath.empty()) {
+        // Load a corpus previously written by --convert. Only the date list
+        // and the query server read timestamps, and no report reads the ids,
+        // so those columns are not rebuilt as strings unless needed.
+        int columns = COL_SENATOR;
+        if (needText) columns |= COL_TEXT;
+        if (serviceMode || rowFilters || (runPlan & RUN_DATES)) columns |= COL_CREATED;
+        tweets = readBinaryCorpus(binaryPath, columns, senatorNames, senatorTable);
+    } else if (pipelined) {
+        bool retainRows = (runPlan & (RUN_ALIGNMENT | RUN_COUNTS | RUN_DATES)) != 0;
+        streamTweetsCsv(tweetsPath, retainRows, lexiconTerms, lexiconScores, negators, negationWindow, sentimentStopFilter, tweets,
+                        tweetCount, senatorNames, senatorTable, senTweets, senWords, senPositive, senNegative, senEmojiPositive,
+                        senEmojiNegative, senTalkWords, bidenTweets, bidenWords, bidenPositive, bidenNegative);
+    } else {
+        // Senators are interned while the rows are parsed
+        tweets = read_tweets_csv_file(tweetsPath, needText ? COL_ALL : COL_ALL & ~COL_TEXT, senatorNames, senatorTable);
+    }
+    if (rowFilters && compressedPath.empty()) {
+        tweets = filterTweetRows(tweets, senatorFilter, fromMillis, toMillis);
+        senatorNames.clear();
+        senatorTable.clear();
+        internSenators(tweets, senatorNames, senatorTable);
+    }
+    long long exactDuplicates = 0;
+    long long nearDuplicates = 0;
+    if (dedupMode != DEDUP_NONE) {
+        tweets = deduplicateTweets(tweets, dedupMode, dedupKeep, dedupThreshold, exactDuplicates, nearDuplicates);
+        senatorNames.clear();
+        senatorTable.clear();
+        internSenators(tweets, senatorNames, senatorTable);
+    }
+    if (!pipelined) tweetCount = static_cast<long long>(tweets.size());
+    vector<string> senators = sortedSenators(senatorNames);
+    if (pipelined) {
+        sortSenatorTotals(senatorNames, senatorTable, senators, senTweets, senWords, senPositive, senNegative, senEmojiPositive,
+                          senEmojiNegative, senTalkWords);
+    }
+    METRIC_TIMER_END(TIMER_LOAD);
+
+    // Query mode: build the stem index once and answer the given terms
+    // Usage: --query term [term...] [other flags]   (terms end at the next --flag)
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) != "--query") continue;
+        vector<string> terms;
+        for (int j = i + 1; j < argc && string(argv[j]).compare(0, 2, "--") != 0; ++j) terms.push_back(argv[j]);
+        if (terms.empty()) {
+            cerr << "Error: --query expects at least one term" << endl;
+            return 1;
+        }
+        vector<string> stems, postings;
+        vector<int> stemTable, postingCounts, tweetWords;
+        vector<double> tweetPositive, tweetNegative;
+        buildInvertedIndex(tweets, lexiconTerms, lexiconScores, negators, negationWindow, sentimentStopFilter, stems, stemTable,
+                           postings, postingCounts, tweetWords, tweetPositive, tweetNegative);
+        cout << "Indexed " << tweets.size() << " tweets, " << stems.size() << " stems." << endl;
+        queryTermSentiment(terms, stems, stemTable, postings, postingCounts, tweetWords, tweetPositive, tweetNegative);
+        return 0;
+    }
+
+    // Train the alignment model on the loaded corpus and save it for --predict
+    // Usage: [loader flags] --save-model <file>
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (string(argv[i]) != "--save-model") continue;
+        vector<string> keyTerms, keyTermParty;
+        trainAlignmentModel(tweets, stopFilter, keyTerms, keyTermParty, maxNgram);
+        if (!saveAlignmentModel(argv[i + 1], keyTerms, keyTermWeights(keyTermParty), negators, negationWindow)) return 1;
+        cout << "Saved " << keyTerms.size() << " terms to " << argv[i + 1] << endl;
+        return 0;
+    }
+
+    // Write this corpus's partial aggregates for --merge (single-word terms only)
+    // Usage: [loader flags] --emit-partial <file>
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (string(argv[i]) != "--emit-partial") continue;
+        if (maxNgram > 1) {
+            cerr << "Error: --emit-partial does not support --ngram-max above 1" << endl;
+            return 1;
+        }
+        int lexiconEntries = lexiconPath.empty() ? -1 : static_cast<int>(lexiconTerms.size());
+        if (!emitAnalysisPartial(argv[i + 1], tweets, senators, static_cast<int>(positiveWords.size()), static_cast<int>(negativeWords.size()),
+                                 lexiconEntries, lexiconTerms, lexiconScores, negators, negationWindow, sentimentStopFilter, stopFilter)) {
+            return 1;
+        }
+        cout << "Wrote partials for " << tweets.size() << " tweets to " << argv[i + 1] << endl;
+        return 0;
+    }
+
+    // Cross-validation mode: --cv <k> for k-fold, --cv senator for leave-one-senator-out
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (string(argv[i]) != "--cv") continue;
+        int folds = (string(argv[i + 1]) == "senator") ? 0 : atoi(argv[i + 1]);
+        if (folds == 1 || folds < 0 || (folds == 0 && string(argv[i + 1]) != "senator")) {
+            cerr << "Error: --cv expects a fold count of at least 2 or \"senator\"" << endl;
+            return 1;
+        }
+        crossValidateAlignment(tweets, senators, negators, negationWindow, stopFilter, folds);
+        return 0;
+    }
+
+    // Benchmark mode: synthetic corpora modelled on the loaded one
+    // Usage: [loader flags] --bench [rows...]   (default 10000 1000000)
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) != "--bench") continue;
+        vector<long long> sizes;
+        for (int j = i + 1; j < argc && atoll(argv[j]) > 0; ++j) sizes.push_back(atoll(argv[j]));
+        if (sizes.empty()) sizes = {10000, 1000000};
+        runBenchmarks(tweets, lexiconTerms, lexiconScores, negators, negationWindow, sentimentStopFilter, stopFilter, sizes, cout);
+        return 0;
+    }
+
+    // Accumulator microbenchmark: layouts of per-senator counters at 1..N threads
+    // Usage: [loader flags] --bench-accumulators [maxThreads] [rows]   (default 64 threads, 4000000 rows)
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) != "--bench-accumulators") continue;
+        int maxThreads = (i + 1 < argc && atoi(argv[i + 1]) > 0) ? atoi(argv[i + 1]) : 64;
+        long long rows = (i + 2 < argc && atoll(argv[i + 2]) > 0) ? atoll(argv[i + 2]) : 4000000;
+        benchAccumulators(tweets, senators, maxThreads, rows, cout);
+        return 0;
+    }
+
+    // Server mode: load and index once, then answer line requests on stdin
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "--serve") {
+            runQueryServer(tweets, lexiconTerms, lexiconScores, negators, negationWindow, sentimentStopFilter, stopFilter, maxNgram, cin, cout);
+            return 0;
+        }
+    }
+
+    // All reports go into one buffer that is written with a single flush
+    ostringstream report;
+    bool table = (reportFormat == REPORT_TABLE);
+    if (table) {
+        report << "Data loaded." << '\n';
+        report << "Tweets: " << tweetCount << '\n';
+        if (dedupMode != DEDUP_NONE) {
+            report << "Duplicates Removed: " << exactDuplicates << " exact, " << nearDuplicates << " near" << '\n';
+        }
+        if (needLexicons) {
+            report << "Positive Words: " << positiveWords.size() << '\n';
+            report << "Negative Words: " << negativeWords.size() << '\n';
+        }
+        if (!lexiconPath.empty()) report << "Lexicon Entries: " << lexiconTerms.size() << '\n';
+        report << "Senators: " << senators.size() << '\n';
+        report << '\n';
+    }
 
     // Part 1: Sentiment Analysis
-    cout << "--- Part 1: Sentiment Analysis ---" << endl;
-    calculateSentiment(tweets, senators, positiveWords, negativeWords);
-    cout << endl;
+    if (runPlan & RUN_SENTIMENT) {
+        if (table) report << "--- Part 1: Sentiment Analysis ---" << '\n';
+        METRIC_TIMER_BEGIN(TIMER_SENTIMENT);
+        if (pipelined) {
+            reportSentiment(senators, senWords, senPositive, senNegative, senEmojiPositive, senEmojiNegative, report, reportFormat);
+        } else {
+            calculateSentiment(tweets, senators, lexiconTerms, lexiconScores, negators, negationWindow, sentimentStopFilter, report,
+                               reportFormat);
+        }
+        METRIC_TIMER_END(TIMER_SENTIMENT);
+        if (table) report << '\n';
+    }
 
     // Part 2: Two Capabilities
-    cout << "--- Part 2: Additional Capabilities ---" << endl;
+    if (table && (runPlan & (RUN_TALKATIVE | RUN_BIDEN))) report << "--- Part 2: Additional Capabilities ---" << '\n';
     
     // Capability 1: Most Talkative Senator
-    cout << "1. Most Talkative Senator:" << endl;
-    findMostTalkative(tweets, senators);
-    cout << endl;
+    if (runPlan & RUN_TALKATIVE) {
+        if (table) report << "1. Most Talkative Senator:" << '\n';
+        METRIC_TIMER_BEGIN(TIMER_TALKATIVE);
+        if (pipelined) {
+            reportMostTalkative(senators, senTweets, senTalkWords, report, reportFormat);
+        } else {
+            findMostTalkative(tweets, senators, report, reportFormat);
+        }
+        METRIC_TIMER_END(TIMER_TALKATIVE);
+        if (table) report << '\n';
+    }
 
     // Capability 2: Biden Sentiment
-    cout << "2. Biden Sentiment Analysis:" << endl;
-    analyzeBidenSentiment(tweets, positiveWords, negativeWords);
-    cout << endl;
+    if (runPlan & RUN_BIDEN) {
+        if (table) report << "2. Biden Sentiment Analysis:" << '\n';
+        METRIC_TIMER_BEGIN(TIMER_BIDEN);
+        if (pipelined) {
+            reportBidenSentiment(bidenTweets, bidenWords, bidenPositive, bidenNegative, report, reportFormat);
+        } else {
+            analyzeBidenSentiment(tweets, lexiconTerms, lexiconScores, negators, negationWindow, sentimentStopFilter, report, reportFormat);
+        }
+        METRIC_TIMER_END(TIMER_BIDEN);
+        if (table) report << '\n';
+    }
 
     // Extra Credit
-    cout << "--- Extra Credit: Political Alignment Analysis ---" << endl;
-    analyzePoliticalAlignment(tweets, senators);
+    if (runPlan & RUN_ALIGNMENT) {
+        if (table) report << "--- Extra Credit: Political Alignment Analysis ---" << '\n';
+        // Usage: --alignment logodds|sketch (default: the key-term model)
+        bool logOdds = false;
+        bool sketch = false;
+        for (int i = 1; i + 1 < argc; ++i) {
+            if (string(argv[i]) == "--alignment" && string(argv[i + 1]) == "logodds") logOdds = true;
+            if (string(argv[i]) == "--alignment" && string(argv[i + 1]) == "sketch") sketch = true;
+        }
+        METRIC_TIMER_BEGIN(TIMER_ALIGNMENT);
+        if (logOdds) {
+            analyzeAlignmentLogOdds(tweets, senators, negators, negationWindow, stopFilter, report, reportFormat);
+        } else if (sketch) {
+            analyzeAlignmentSketch(tweets, senators, negators, negationWindow, stopFilter, report, reportFormat);
+        } else {
+            analyzePoliticalAlignment(tweets, senators, negators, negationWindow, stopFilter, report, reportFormat, maxNgram);
+        }
+        METRIC_TIMER_END(TIMER_ALIGNMENT);
+    }
+
+    // Metadata reports
+    if (runPlan & RUN_COUNTS) reportTweetCounts(tweets, senators, report, reportFormat);
+    if (runPlan & RUN_DATES) reportDateHistogram(tweets, report, reportFormat);
+    if (runPlan & RUN_SENATORS) reportSenatorList(senators, report, reportFormat);
 
+    const string& text = report.str();
+    cout.write(text.data(), static_cast<streamsize>(text.size()));
+    cout.flush();
     return 0;
 }
 
 // Reads the tweets CSV file into a 2D vector
 vector<vector<string>> read_tweets_csv_file() {
-    vector<vector<string>> tweets;
+    return read_tweets_csv_file("tweets.csv");
+}
+
+// Reads a tweets CSV file at the given path into a 2D vector
+vector<vector<string>> read_tweets_csv_file(string path, int columns) {
+    vector<string> senatorNames;
+    vector<int> senatorTable;
+    return read_tweets_csv_file(path, columns, senatorNames, senatorTable);
+}
+
+// Same, also interning each row's senator into senatorNames (ids in first-seen order)
+vector<vector<string>> read_tweets_csv_file(string path, int columns, vector<string>& senatorNames, vector<int>& senatorTable) {
     fstream fin;
-    fin.open("tweets.csv", ios::in);
+    fin.open(path, ios::in);
     if (!fin.is_open()) {
-        cerr << "Error: Could not open tweets.csv" << endl;
-        return tweets;
+        cerr << "Error: Could not open " << path << endl;
+        return vector<vector<string>>();
     }
+    vector<vector<string>> tweets = parseTweetsCsv(fin, columns, senatorNames, senatorTable);
+    fin.close();
+    return tweets;
+}
+
+// Parses pipe-separated tweet rows (after a header line) from any stream.
+// Columns outside the projection are left empty. Without COL_TEXT the stream
+// is scanned in large blocks: the four metadata fields are split out and the
+// rest of each line is skipped with a newline search, never copied.
+vector<vector<string>> parseTweetsCsv(istream& fin, int columns) {
+    vector<string> senatorNames;
+    vector<int> senatorTable;
+    return parseTweetsCsv(fin, columns, senatorNames, senatorTable);
+}
 
+// Same, also interning each kept row's senator as it is parsed
+vector<vector<string>> parseTweetsCsv(istream& fin, int columns, vector<string>& senatorNames, vector<int>& senatorTable) {
+    METRIC_TIMER_BEGIN(TIMER_PARSE_CSV);
+    bool internSenator = (columns & COL_SENATOR) != 0;
+    vector<vector<string>> tweets;
     string line, word;
     vector<string> row;
     
     // Skip header
     getline(fin, line);
 
+    if (!(columns & COL_TEXT)) {
+        const size_t BLOCK = 1 << 20;
+        string block;
+        string carry;  // partial metadata of a line cut by the block boundary
+        vector<char> chunk(BLOCK);
+        int field = 0;
+        bool skipping = false;  // inside the text field
+        bool hasText = false;
+        row.assign(5, "");
+        while (fin.read(chunk.data(), BLOCK) || fin.gcount() > 0) {
+            const char* p = chunk.data();
+            const char* end = p + fin.gcount();
+            while (p < end) {
+                if (skipping) {
+                    const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+                    if (nl != p) hasText = true;
+                    if (!nl) {
+                        p = end;
+                        break;
+                    }
+                    // getline drops an empty trailing field, so such rows have 4 columns
+                    if (hasText) {
+                        tweets.push_back(row);
+                        if (internSenator) internString(row[3], senatorNames, senatorTable);
+                    }
+                    p = nl + 1;
+                    skipping = false;
+                    hasText = false;
+                    field = 0;
+                    row.assign(5, "");
+                    continue;
+                }
+                const char c = *p++;
+                if (c == '\n') {
+                    // Fewer than five fields: not a tweet row
+                    field = 0;
+                    carry.clear();
+                    row.assign(5, "");
+                } else if (c == '|') {
+                    if (columns & (1 << field)) row[field] = carry;
+                    carry.clear();
+                    field++;
+                    if (field == 4) skipping = true;
+                } else {
+                    carry += c;
+                }
+            }
+        }
+        if (skipping && hasText) {
+            tweets.push_back(row);
+            if (internSenator) internString(row[3], senatorNames, senatorTable);
+        }
+        METRIC_ADD(COUNTER_ROWS_PARSED, static_cast<long long>(tweets.size()));
+        METRIC_TIMER_END(TIMER_PARSE_CSV);
+        return tweets;
+    }
+
     while (getline(fin, line)) {
         row.clear();
         stringstream s(line);
@@ -84,434 +899,4771 @@ vector<vector<string>> read_tweets_csv_file() {
         // Ensure we have all columns (ID, UserID, Date, Senator, Text)
         if (row.size() >= 5) {
             tweets.push_back(row);
+            if (internSenator) internString(row[3], senatorNames, senatorTable);
+        }
+    }
+    METRIC_ADD(COUNTER_ROWS_PARSED, static_cast<long long>(tweets.size()));
+    METRIC_TIMER_END(TIMER_PARSE_CSV);
+    return tweets;
+}
+
+// ---------------------------------------------------------------------------
+// Streamed load (--pipeline)
+//
+// Reading, parsing and scoring overlap: a reader thread reads fixed-size
+// blocks cut at line ends, a parser thread splits them into row batches, and
+// the calling thread folds each batch into the Part 1, talkative and Biden
+// aggregates as it arrives. The stages hand off through bounded
+// single-producer single-consumer rings, so at most PIPELINE_DEPTH blocks and
+// batches are in flight and a fast reader waits for the scorer instead of
+// buffering the file. Rows are only kept when a later report needs them.
+// ---------------------------------------------------------------------------
+
+// A ring is a vector of PIPELINE_DEPTH slots plus two counters that only
+// grow: the producer owns tail, the consumer head.
+// Waits for a free slot and returns its index
+size_t ringReserve(const atomic<size_t>& head, const atomic<size_t>& tail) {
+    size_t t = tail.load(memory_order_relaxed);
+    if (t - head.load(memory_order_acquire) >= PIPELINE_DEPTH) {
+        METRIC_ADD(COUNTER_QUEUE_WAITS, 1);
+        while (t - head.load(memory_order_acquire) >= PIPELINE_DEPTH) this_thread::yield();
+    }
+    return t & (PIPELINE_DEPTH - 1);
+}
+
+// Hands the reserved slot to the consumer
+void ringPublish(atomic<size_t>& tail) {
+    tail.store(tail.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+// Waits for a filled slot; false once the producer is done and the ring is drained
+bool ringAcquire(const atomic<size_t>& head, const atomic<size_t>& tail, const atomic<bool>& done, size_t& slot) {
+    size_t h = head.load(memory_order_relaxed);
+    while (tail.load(memory_order_acquire) == h) {
+        // done is set after the last publish, so a drained ring stays drained
+        if (done.load(memory_order_acquire) && tail.load(memory_order_acquire) == h) return false;
+        this_thread::yield();
+    }
+    slot = h & (PIPELINE_DEPTH - 1);
+    return true;
+}
+
+// Returns the acquired slot to the producer
+void ringRelease(atomic<size_t>& head) {
+    head.store(head.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+// Reader stage: blocks of whole lines; a line cut by the block boundary is
+// carried into the next block
+void pipelineReader(istream& fin, vector<string>& blocks, const atomic<size_t>& blockHead, atomic<size_t>& blockTail,
+                    atomic<bool>& readerDone) {
+    string carry;
+    vector<char> chunk(PIPELINE_BLOCK_BYTES);
+    while (fin.read(chunk.data(), PIPELINE_BLOCK_BYTES) || fin.gcount() > 0) {
+        size_t got = static_cast<size_t>(fin.gcount());
+        size_t cut = got;
+        while (cut > 0 && chunk[cut - 1] != '\n') cut--;
+        if (cut == 0) {
+            carry.append(chunk.data(), got);
+            continue;
+        }
+        size_t slot = ringReserve(blockHead, blockTail);
+        blocks[slot].swap(carry);
+        blocks[slot].append(chunk.data(), cut);
+        carry.assign(chunk.data() + cut, got - cut);
+        ringPublish(blockTail);
+    }
+    if (!carry.empty()) {
+        size_t slot = ringReserve(blockHead, blockTail);
+        blocks[slot].swap(carry);
+        ringPublish(blockTail);
+    }
+    readerDone.store(true, memory_order_release);
+}
+
+// Parser stage: splits lines like parseTweetsCsv (header skipped, rows with
+// at least five fields kept) into batches of PIPELINE_BATCH_ROWS rows
+void pipelineParser(vector<string>& blocks, atomic<size_t>& blockHead, const atomic<size_t>& blockTail, const atomic<bool>& readerDone,
+                    vector<vector<vector<string>>>& batches, const atomic<size_t>& batchHead, atomic<size_t>& batchTail,
+                    atomic<bool>& parserDone) {
+    bool header = true;
+    vector<vector<string>> batch;
+    vector<string> row;
+    size_t slot = 0;
+    while (ringAcquire(blockHead, blockTail, readerDone, slot)) {
+        const string& block = blocks[slot];
+        size_t pos = 0;
+        while (pos < block.size()) {
+            size_t end = block.find('\n', pos);
+            if (end == string::npos) end = block.size();
+            if (header) {
+                header = false;
+                pos = end + 1;
+                continue;
+            }
+            // Split on '|'; like getline, an empty last field is dropped
+            row.clear();
+            size_t start = pos;
+            while (start < end) {
+                size_t bar = block.find('|', start);
+                if (bar == string::npos || bar >= end) bar = end;
+                row.push_back(block.substr(start, bar - start));
+                start = bar + 1;
+            }
+            if (row.size() >= 5) {
+                batch.push_back(row);
+                if (batch.size() == PIPELINE_BATCH_ROWS) {
+                    size_t out = ringReserve(batchHead, batchTail);
+                    batches[out].swap(batch);
+                    ringPublish(batchTail);
+                    batch.clear();
+                }
+            }
+            pos = end + 1;
+        }
+        ringRelease(blockHead);
+    }
+    if (!batch.empty()) {
+        size_t out = ringReserve(batchHead, batchTail);
+        batches[out].swap(batch);
+        ringPublish(batchTail);
+    }
+    parserDone.store(true, memory_order_release);
+}
+
+// Loads a tweets CSV through the pipeline, scoring every row into the Part 1,
+// talkative and Biden aggregates on the calling thread. Senator totals are
+// indexed by first-seen id, as in senatorNames. Rows are appended to tweets
+// only when retainRows is set; tweetCount counts them either way.
+void streamTweetsCsv(string path, bool retainRows, const vector<string>& lexiconTerms, const vector<double>& lexiconScores,
+                     const vector<string>& negators, int negationWindow, const vector<unsigned long long>& stopFilter,
+                     vector<vector<string>>& tweets, long long& tweetCount, vector<string>& senatorNames, vector<int>& senatorTable,
+                     vector<int>& senTweets, vector<int>& senWords, vector<double>& senPositive, vector<double>& senNegative,
+                     vector<int>& senEmojiPositive, vector<int>& senEmojiNegative, vector<int>& senTalkWords, int& bidenTweets,
+                     int& bidenWords, double& bidenPositive, double& bidenNegative) {
+    tweetCount = 0;
+    ifstream fin(path, ios::binary);
+    if (!fin.is_open()) {
+        cerr << "Error: Could not open " << path << endl;
+        return;
+    }
+    METRIC_TIMER_BEGIN(TIMER_PARSE_CSV);
+    vector<unsigned long long> trieKeys;
+    vector<int> trieChild;
+    vector<double> nodeWeights;
+    compileLexicon(lexiconTerms, lexiconScores, trieKeys, trieChild, nodeWeights);
+    vector<unsigned long long> negHashes = negatorHashes(negators);
+
+    vector<string> blocks(PIPELINE_DEPTH);
+    vector<vector<vector<string>>> batches(PIPELINE_DEPTH);
+    atomic<size_t> blockHead(0), blockTail(0), batchHead(0), batchTail(0);
+    atomic<bool> readerDone(false), parserDone(false);
+    thread reader([&]() { pipelineReader(fin, blocks, blockHead, blockTail, readerDone); });
+    thread parser([&]() {
+        pipelineParser(blocks, blockHead, blockTail, readerDone, batches, batchHead, batchTail, parserDone);
+    });
+
+    int emojiPos = 0;  // Biden emoji are only reported per senator
+    int emojiNeg = 0;
+    size_t slot = 0;
+    while (ringAcquire(batchHead, batchTail, parserDone, slot)) {
+        for (vector<string>& row : batches[slot]) {
+            int id = internString(row[3], senatorNames, senatorTable);
+            if (id == static_cast<int>(senTweets.size())) {
+                senTweets.push_back(0);
+                senWords.push_back(0);
+                senPositive.push_back(0.0);
+                senNegative.push_back(0.0);
+                senEmojiPositive.push_back(0);
+                senEmojiNegative.push_back(0);
+                senTalkWords.push_back(0);
+            }
+            const string& text = row[4];
+            senTweets[id]++;
+            scoreTextSentiment(text, trieKeys, trieChild, nodeWeights, negHashes, negationWindow, stopFilter, senWords[id], senPositive[id],
+                               senNegative[id], senEmojiPositive[id], senEmojiNegative[id]);
+            stringstream ss(text);
+            string word;
+            while (ss >> word) {
+                senTalkWords[id]++;
+            }
+            // Scored again into its own totals so the sums match analyzeBidenSentiment
+            if (normalizeUtf8(text).find("biden") != string::npos) {
+                bidenTweets++;
+                scoreTextSentiment(text, trieKeys, trieChild, nodeWeights, negHashes, negationWindow, stopFilter, bidenWords, bidenPositive,
+                                   bidenNegative, emojiPos, emojiNeg);
+            }
+            tweetCount++;
+            if (retainRows) tweets.push_back(move(row));
+        }
+        batches[slot].clear();
+        ringRelease(batchHead);
+    }
+    reader.join();
+    parser.join();
+    METRIC_ADD(COUNTER_ROWS_PARSED, tweetCount);
+    METRIC_TIMER_END(TIMER_PARSE_CSV);
+}
+
+// ---------------------------------------------------------------------------
+// Duplicate removal (--dedup)
+//
+// Runs once over the loaded rows, ahead of every analysis. A tweet's text is
+// normalized to its words (case folded, letters only, without a leading
+// "RT", URLs and @handles). Tweets with the same normalized words are exact
+// duplicates, found through a hash table of the normalized text. For near
+// duplicates each tweet gets a MinHash signature of MINHASH_SIZE minima over
+// its word 3-shingles. The signature is cut into bands whose hashes index an
+// LSH table, with the band width picked so that pairs at the threshold
+// almost always share a band. A tweet sharing any band with a kept tweet is
+// compared with it by signature, and counts as a duplicate if the estimated
+// Jaccard similarity reaches the threshold. Time is linear in the corpus.
+// Memory is the two hash tables plus one signature per kept tweet. Each
+// group of duplicates keeps one row: its first, last or longest.
+// ---------------------------------------------------------------------------
+
+// Words of a tweet as compared for duplicates
+vector<string> dedupTokens(const string& text) {
+    vector<string> tokens;
+    stringstream ss(text);
+    string word;
+    bool first = true;
+    while (ss >> word) {
+        bool retweetMark = first && word == "RT";
+        first = false;
+        if (retweetMark || word[0] == '@' || word.compare(0, 4, "http") == 0) continue;
+        string clean = cleanWord(word);
+        if (!clean.empty()) tokens.push_back(clean);
+    }
+    return tokens;
+}
+
+// True if other is the same text as text (whose dedupTokens are tokens) for
+// exact dedup: equal bytes, or the same word sequence. Texts without words
+// only match byte for byte.
+bool sameDedupText(const string& text, const vector<string>& tokens, const string& other) {
+    if (text == other) return true;
+    return !tokens.empty() && dedupTokens(other) == tokens;
+}
+
+// Value stored for key in an open-addressing table (key 0 = empty), or -1
+int findKey(const vector<unsigned long long>& keys, const vector<int>& values, unsigned long long key) {
+    if (keys.empty()) return -1;
+    if (key == 0) key = 1;
+    size_t mask = keys.size() - 1;
+    size_t slot = sketchHash(key) & mask;
+    while (keys[slot] != 0) {
+        if (keys[slot] == key) return values[slot];
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+// Stores key -> value unless key is present; the table grows when half full
+void insertKey(vector<unsigned long long>& keys, vector<int>& values, size_t& used, unsigned long long key, int value) {
+    if (key == 0) key = 1;
+    if (keys.empty() || used * 2 >= keys.size()) {
+        vector<unsigned long long> oldKeys;
+        vector<int> oldValues;
+        oldKeys.swap(keys);
+        oldValues.swap(values);
+        size_t newSize = oldKeys.empty() ? 1024 : oldKeys.size() * 2;
+        keys.assign(newSize, 0);
+        values.assign(newSize, -1);
+        for (size_t i = 0; i < oldKeys.size(); ++i) {
+            if (oldKeys[i] == 0) continue;
+            size_t slot = sketchHash(oldKeys[i]) & (newSize - 1);
+            while (keys[slot] != 0) slot = (slot + 1) & (newSize - 1);
+            keys[slot] = oldKeys[i];
+            values[slot] = oldValues[i];
+        }
+    }
+    size_t mask = keys.size() - 1;
+    size_t slot = sketchHash(key) & mask;
+    while (keys[slot] != 0) {
+        if (keys[slot] == key) return;
+        slot = (slot + 1) & mask;
+    }
+    keys[slot] = key;
+    values[slot] = value;
+    used++;
+}
+
+// MinHash signature of the tokens' word shingles (the whole text is one
+// shingle when it has fewer words). The MINHASH_SIZE hash functions are
+// derived from one 64-bit hash per shingle by double hashing.
+void minHashSignature(const vector<string>& tokens, unsigned int* signature) {
+    for (int h = 0; h < MINHASH_SIZE; ++h) signature[h] = 0xFFFFFFFFu;
+    size_t shingles = (tokens.size() > SHINGLE_WORDS) ? tokens.size() - SHINGLE_WORDS + 1 : 1;
+    for (size_t i = 0; i < shingles; ++i) {
+        unsigned long long shingle = 0;
+        for (size_t k = i; k < tokens.size() && k < i + SHINGLE_WORDS; ++k) {
+            shingle = ngramHash(shingle, fnv1aHash(tokens[k], 0, tokens[k].size()));
+        }
+        unsigned long long mixed = sketchHash(shingle);
+        unsigned int h1 = static_cast<unsigned int>(mixed);
+        unsigned int h2 = static_cast<unsigned int>(mixed >> 32) | 1;
+        for (int h = 0; h < MINHASH_SIZE; ++h) {
+            unsigned int value = h1 + static_cast<unsigned int>(h) * h2;
+            if (value < signature[h]) signature[h] = value;
+        }
+    }
+}
+
+// Signature rows per LSH band: the widest band (fewest false candidates)
+// whose S-curve midpoint, (1 / bands)^(1 / rows), is at least 0.1 below the
+// threshold. 0.8 gives 16 bands of 4 rows (midpoint 0.5).
+int minHashBandRows(double threshold) {
+    for (int rows = 16; rows > 1; rows /= 2) {
+        double bands = static_cast<double>(MINHASH_SIZE / rows);
+        if (pow(1.0 / bands, 1.0 / rows) <= threshold - 0.1) return rows;
+    }
+    return 1;
+}
+
+// Rows left after removing duplicates, in corpus order; counts the exact
+// and near duplicates removed
+vector<vector<string>> deduplicateTweets(const vector<vector<string>>& tweets, DedupMode mode, DedupKeep keep, double threshold,
+                                         long long& exactRemoved, long long& nearRemoved) {
+    METRIC_TIMER_BEGIN(TIMER_DEDUP);
+    exactRemoved = 0;
+    nearRemoved = 0;
+    vector<unsigned long long> exactKeys, bandKeys;
+    vector<int> exactEntries, bandGroups;
+    vector<size_t> entryRow;  // the row whose text each exact key was taken from
+    vector<int> entryGroup;
+    size_t exactUsed = 0;
+    size_t bandUsed = 0;
+    vector<unsigned int> signatures;  // MINHASH_SIZE per group (near mode)
+    vector<size_t> groupRow;          // the row each group keeps
+    vector<char> kept(tweets.size(), 0);
+    int minAgree = static_cast<int>(ceil(threshold * MINHASH_SIZE));
+    int bandRows = minHashBandRows(threshold);
+    int bands = MINHASH_SIZE / bandRows;
+    unsigned int signature[MINHASH_SIZE];
+    unsigned long long rowBands[MINHASH_SIZE];
+
+    for (size_t r = 0; r < tweets.size(); ++r) {
+        if (tweets[r].size() < 5 || tweets[r][4].empty()) {
+            kept[r] = 1;
+            continue;
+        }
+        // Texts without words (emoji or links only) are only matched exactly, by their raw bytes
+        vector<string> tokens = dedupTokens(tweets[r][4]);
+        unsigned long long textKey = 0;
+        for (const string& token : tokens) textKey = ngramHash(textKey, fnv1aHash(token, 0, token.size()));
+        if (tokens.empty()) textKey = ngramHash(0, fnv1aHash(tweets[r][4], 0, tweets[r][4].size()));
+
+        // A key match is only a duplicate if the text matches too, so a 64-bit
+        // collision cannot drop a distinct tweet; the colliding text is then
+        // left out of the exact table
+        int entry = findKey(exactKeys, exactEntries, textKey);
+        bool collided = (entry >= 0 && !sameDedupText(tweets[r][4], tokens, tweets[entryRow[entry]][4]));
+        int group = (entry >= 0 && !collided) ? entryGroup[entry] : -1;
+        bool exact = (group >= 0);
+        bool compared = (mode == DEDUP_NEAR && !tokens.empty());
+        if (!exact && compared) {
+            minHashSignature(tokens, signature);
+            for (int band = 0; band < bands; ++band) {
+                unsigned long long bandKey = static_cast<unsigned long long>(band) + 1;
+                for (int k = 0; k < bandRows; ++k) bandKey = ngramHash(bandKey, signature[band * bandRows + k]);
+                rowBands[band] = bandKey;
+                int candidate = findKey(bandKeys, bandGroups, bandKey);
+                if (candidate < 0 || group >= 0) continue;
+                const unsigned int* other = &signatures[static_cast<size_t>(candidate) * MINHASH_SIZE];
+                int agree = 0;
+                for (int h = 0; h < MINHASH_SIZE; ++h) agree += (signature[h] == other[h]);
+                if (agree >= minAgree) group = candidate;
+            }
+        }
+
+        if (group < 0) {
+            // A new group, kept and indexed by its text and bands
+            group = static_cast<int>(groupRow.size());
+            groupRow.push_back(r);
+            kept[r] = 1;
+            if (entry < 0) {
+                insertKey(exactKeys, exactEntries, exactUsed, textKey, static_cast<int>(entryRow.size()));
+                entryRow.push_back(r);
+                entryGroup.push_back(group);
+            }
+            if (mode == DEDUP_NEAR) {
+                // Every group gets a signature slot; groups without words are never banded
+                if (!compared) fill(signature, signature + MINHASH_SIZE, 0xFFFFFFFFu);
+                signatures.insert(signatures.end(), signature, signature + MINHASH_SIZE);
+                if (compared) {
+                    for (int band = 0; band < bands; ++band) insertKey(bandKeys, bandGroups, bandUsed, rowBands[band], group);
+                }
+            }
+            continue;
+        }
+        if (exact) {
+            exactRemoved++;
+        } else {
+            // Later exact copies of this text join the same group
+            nearRemoved++;
+            if (entry < 0) {
+                insertKey(exactKeys, exactEntries, exactUsed, textKey, static_cast<int>(entryRow.size()));
+                entryRow.push_back(r);
+                entryGroup.push_back(group);
+            }
+        }
+        size_t& row = groupRow[group];
+        if (keep == KEEP_LAST || (keep == KEEP_LONGEST && tweets[r][4].size() > tweets[row][4].size())) {
+            kept[row] = 0;
+            kept[r] = 1;
+            row = r;
+        }
+    }
+
+    vector<vector<string>> unique;
+    for (size_t r = 0; r < tweets.size(); ++r) {
+        if (kept[r]) unique.push_back(tweets[r]);
+    }
+    METRIC_ADD(COUNTER_DUPLICATES, exactRemoved + nearRemoved);
+    METRIC_TIMER_END(TIMER_DEDUP);
+    return unique;
+}
+
+// Reads an emotion word file into a vector
+vector<string> readEmotionFile(string path) {
+    vector<string> words;
+    fstream fin;
+    fin.open(path, ios::in);
+    if (!fin.is_open()) {
+        cerr << "Error: Could not open " << path << endl;
+        return words;
+    }
+
+    string word;
+    while (fin >> word) {
+        words.push_back(word);
+    }
+    fin.close();
+    return words;
+}
+
+// Gets the sorted list of unique senators: one hashed intern pass over the
+// rows, then a sort of the distinct names only
+vector<string> getUniqueSenators(const vector<vector<string>>& tweets) {
+    vector<string> senatorNames;
+    vector<int> senatorTable;
+    internSenators(tweets, senatorNames, senatorTable);
+    return sortedSenators(senatorNames);
+}
+
+// Interns every row's senator; a senator's id is its index in senatorNames,
+// assigned in first-seen order and stable as more rows are interned
+void internSenators(const vector<vector<string>>& tweets, vector<string>& senatorNames, vector<int>& senatorTable) {
+    for (const auto& row : tweets) {
+        if (row.size() >= 4) internString(row[3], senatorNames, senatorTable);
+    }
+}
+
+// Sorted copy of the interned names, for reports
+vector<string> sortedSenators(const vector<string>& senatorNames) {
+    vector<string> senators(senatorNames);
+    sort(senators.begin(), senators.end());
+    return senators;
+}
+
+// Helper to determine party affiliation
+string getParty(string senator) {
+    // Hardcoded mapping based on known affiliations of the senators in the dataset
+    if (senator == "Dan Sullivan" || senator == "Cory Gardner" || senator == "Jeff Flake" || 
+        senator == "John Boozman" || senator == "Jon Kyl" || senator == "Lisa Murkowski" || 
+        senator == "Richard Shelby" || senator == "Tom Cotton") {
+        return "Republican";
+    } else {
+        return "Democrat";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// UTF-8 normalization
+//
+// Text is UTF-8. ASCII runs are found 32 bytes at a time by testing the high
+// bit of four 64-bit words at once, and only the bytes after a set high bit
+// are decoded. Decoded code points are case folded for the Latin blocks
+// (Latin-1, Extended-A/B, Extended Additional; fullwidth Latin folds to
+// ASCII), variation selectors are dropped, and malformed sequences become
+// U+FFFD. Tokens keep ASCII letters and Latin letters, so "Café" and "CAFÉ"
+// are one term instead of "caf". ASCII text goes through unchanged apart
+// from lowercasing.
+// ---------------------------------------------------------------------------
+
+const unsigned int REPLACEMENT_CHARACTER = 0xFFFD;
+
+// Length of the leading run of ASCII bytes in p[0, n)
+inline size_t asciiPrefixLength(const char* p, size_t n) {
+    const unsigned long long HIGH_BITS = 0x8080808080808080ULL;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        unsigned long long w[4];
+        memcpy(w, p + i, 32);
+        if (((w[0] | w[1] | w[2] | w[3]) & HIGH_BITS) != 0) break;
+    }
+    for (; i + 8 <= n; i += 8) {
+        unsigned long long w;
+        memcpy(&w, p + i, 8);
+        if ((w & HIGH_BITS) != 0) break;
+    }
+    while (i < n && static_cast<unsigned char>(p[i]) < 0x80) i++;
+    return i;
+}
+
+// Decodes the sequence starting at p[0] (a byte with the high bit set).
+// Sets length to the bytes consumed; overlong forms, surrogates and
+// truncated sequences decode as U+FFFD of length 1.
+constexpr unsigned int decodeUtf8(const char* p, size_t n, size_t& length) {
+    unsigned char lead = static_cast<unsigned char>(p[0]);
+    length = 1;
+    size_t need = (lead >= 0xF0 && lead <= 0xF4) ? 4 : (lead >= 0xE0) ? 3 : (lead >= 0xC2 && lead <= 0xDF) ? 2 : 0;
+    if (need == 0 || lead > 0xF4 || need > n) return REPLACEMENT_CHARACTER;
+    unsigned int cp = lead & (0x7F >> need);
+    for (size_t k = 1; k < need; ++k) {
+        unsigned char c = static_cast<unsigned char>(p[k]);
+        if ((c & 0xC0) != 0x80) return REPLACEMENT_CHARACTER;
+        cp = (cp << 6) | (c & 0x3F);
+    }
+    if ((need == 3 && cp < 0x800) || (need == 4 && (cp < 0x10000 || cp > 0x10FFFF)) || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        return REPLACEMENT_CHARACTER;
+    }
+    length = need;
+    return cp;
+}
+
+// Simple case folding for the Latin blocks; other code points are returned as is
+constexpr unsigned int foldCodePoint(unsigned int cp) {
+    if (cp >= 'A' && cp <= 'Z') return cp + 0x20;
+    if (cp < 0xC0) return cp;
+    if (cp <= 0xDE) return (cp == 0xD7) ? cp : cp + 0x20;
+    if (cp < 0x100) return cp;
+    if (cp == 0x130) return 'i';
+    if (cp == 0x178) return 0xFF;
+    if ((cp <= 0x12F || (cp >= 0x132 && cp <= 0x137) || (cp >= 0x14A && cp <= 0x177)) && cp % 2 == 0) return cp + 1;
+    if (((cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E)) && cp % 2 == 1) return cp + 1;
+    if (cp >= 0x1CD && cp <= 0x1DC) return (cp % 2 == 1) ? cp + 1 : cp;
+    if ((cp >= 0x1DE && cp <= 0x1EF) || (cp >= 0x1F8 && cp <= 0x21F) || (cp >= 0x222 && cp <= 0x233)) {
+        return (cp % 2 == 0) ? cp + 1 : cp;
+    }
+    if (cp == 0x1E9E) return 0xDF;
+    if ((cp >= 0x1E00 && cp <= 0x1E95) || (cp >= 0x1EA0 && cp <= 0x1EFF)) return (cp % 2 == 0) ? cp + 1 : cp;
+    if (cp >= 0xFF21 && cp <= 0xFF3A) return cp - 0xFF21 + 'a';
+    if (cp >= 0xFF41 && cp <= 0xFF5A) return cp - 0xFF41 + 'a';
+    return cp;
+}
+
+// Whether a folded code point is a letter that words are made of
+constexpr bool isWordCodePoint(unsigned int cp) {
+    return (cp >= 'a' && cp <= 'z') || (cp >= 0xDF && cp <= 0x24F && cp != 0xF7) || (cp >= 0x1E00 && cp <= 0x1EFF);
+}
+
+// Encodes cp into buf (at least 4 bytes); returns the byte count
+constexpr size_t encodeUtf8(unsigned int cp, char* buf) {
+    if (cp < 0x80) {
+        buf[0] = static_cast<char>(cp);
+        return 1;
+    }
+    if (cp < 0x800) {
+        buf[0] = static_cast<char>(0xC0 | (cp >> 6));
+        buf[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        buf[0] = static_cast<char>(0xE0 | (cp >> 12));
+        buf[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        buf[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    buf[0] = static_cast<char>(0xF0 | (cp >> 18));
+    buf[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    buf[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    buf[3] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Case-folded, validated copy of a UTF-8 string (variation selectors dropped)
+string normalizeUtf8(const string& text) {
+    string out;
+    out.reserve(text.size());
+    const char* p = text.data();
+    size_t n = text.size();
+    size_t i = 0;
+    while (i < n) {
+        size_t run = asciiPrefixLength(p + i, n - i);
+        for (size_t end = i + run; i < end; ++i) {
+            char c = p[i];
+            out += (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+        }
+        if (i >= n) break;
+        size_t length = 1;
+        unsigned int cp = foldCodePoint(decodeUtf8(p + i, n - i, length));
+        i += length;
+        if (cp == 0xFE0E || cp == 0xFE0F) continue;
+        char buf[4] = {};
+        out.append(buf, encodeUtf8(cp, buf));
+    }
+    return out;
+}
+
+// Keeps only the letters of a word, case folded ("Biden's" -> "bidens",
+// "Café" -> "café")
+string cleanWord(const string& word) {
+    string clean = "";
+    const char* p = word.data();
+    size_t n = word.size();
+    for (size_t i = 0; i < n;) {
+        unsigned char c = static_cast<unsigned char>(p[i]);
+        if (c < 0x80) {
+            if (isAsciiLetter(static_cast<char>(c))) clean += static_cast<char>(c | 0x20);
+            i++;
+            continue;
+        }
+        size_t length = 1;
+        unsigned int cp = foldCodePoint(decodeUtf8(p + i, n - i, length));
+        i += length;
+        if (!isWordCodePoint(cp)) continue;
+        char buf[4] = {};
+        clean.append(buf, encodeUtf8(cp, buf));
+    }
+    return clean;
+}
+
+// Stems a token after normalizing it; ASCII tokens skip the normalizer
+// since the stemmer lowercases them itself
+string stemToken(const string& word) {
+    if (asciiPrefixLength(word.data(), word.size()) == word.size()) return stemString(word);
+    return stemString(normalizeUtf8(word));
+}
+
+// Whitespace as stringstream's >> splits on it, without the locale lookup of isspace
+inline bool isTokenSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+constexpr bool isAsciiLetter(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+// Folds the character at p[0] into a term hash if it is a letter; returns
+// the bytes it spans. Non-ASCII bytes are decoded only here.
+constexpr size_t hashTermChar(const char* p, size_t n, unsigned long long& hash) {
+    if (static_cast<unsigned char>(p[0]) < 0x80) {
+        if (isAsciiLetter(p[0])) {
+            hash ^= static_cast<unsigned char>(p[0] | 0x20);
+            hash *= 1099511628211ULL;
+        }
+        return 1;
+    }
+    size_t length = 1;
+    unsigned int cp = foldCodePoint(decodeUtf8(p, n, length));
+    if (isWordCodePoint(cp)) {
+        char buf[4] = {};
+        size_t bytes = encodeUtf8(cp, buf);
+        for (size_t k = 0; k < bytes; ++k) {
+            hash ^= static_cast<unsigned char>(buf[k]);
+            hash *= 1099511628211ULL;
+        }
+    }
+    return length;
+}
+
+// Hash of a token's letters, case folded, as cleanWord would produce them.
+// 0 is reserved for empty scorer slots. constexpr so built-in word lists can
+// be hashed at compile time.
+constexpr unsigned long long termHashOf(const char* word, size_t length) {
+    unsigned long long hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < length;) {
+        i += hashTermChar(word + i, length - i, hash);
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+unsigned long long termHash(const string& word) {
+    return termHashOf(word.data(), word.size());
+}
+
+// ---------------------------------------------------------------------------
+// Stop words
+//
+// Stop words are matched with a minimal perfect hash: every word's term hash
+// is multiplied by a constant chosen so that no two words land in the same
+// slot, so membership is one multiply, one load and one compare. The
+// built-in list is hashed and its multiplier found at compile time (the
+// static_assert fails the build if none exists); a list loaded with
+// --stop-words gets its multiplier searched once at startup. A filter is the
+// slot table with the multiplier appended as its last entry.
+// ---------------------------------------------------------------------------
+
+constexpr const char* DEFAULT_STOP_WORDS[] = {
+    "the", "is", "and", "to", "of", "a", "in", "for", "on", "with", "at", "by",
+    "from", "up", "about", "into", "over", "after", "this", "that", "it", "are", "was", "be",
+    "has", "have", "will", "as", "an", "or", "but", "not", "no", "we", "our", "us",
+    "my", "i", "you", "your", "he", "she", "they", "their", "his", "her", "rt", "amp"
+};
+constexpr int DEFAULT_STOP_WORD_COUNT = sizeof(DEFAULT_STOP_WORDS) / sizeof(DEFAULT_STOP_WORDS[0]);
+constexpr size_t DEFAULT_STOP_TABLE_SIZE = 256;
+
+constexpr size_t stopSlot(unsigned long long hash, unsigned long long multiplier, size_t tableSize) {
+    return static_cast<size_t>((hash * multiplier) >> 32) & (tableSize - 1);
+}
+
+// The n-th candidate multiplier (odd, spread over the 64-bit range)
+constexpr unsigned long long stopMultiplier(int attempt) {
+    return (0x9E3779B97F4A7C15ULL + 2 * 0x632BE59BD9B4E019ULL * static_cast<unsigned long long>(attempt)) | 1;
+}
+
+// Finds a collision-free multiplier for the built-in list, or 0
+constexpr unsigned long long findDefaultStopMultiplier() {
+    for (int attempt = 0; attempt < 10000; ++attempt) {
+        unsigned long long multiplier = stopMultiplier(attempt);
+        bool used[DEFAULT_STOP_TABLE_SIZE] = {};
+        bool perfect = true;
+        for (int i = 0; i < DEFAULT_STOP_WORD_COUNT && perfect; ++i) {
+            const char* word = DEFAULT_STOP_WORDS[i];
+            size_t slot = stopSlot(termHashOf(word, char_traits<char>::length(word)), multiplier, DEFAULT_STOP_TABLE_SIZE);
+            perfect = !used[slot];
+            used[slot] = true;
+        }
+        if (perfect) return multiplier;
+    }
+    return 0;
+}
+
+constexpr unsigned long long DEFAULT_STOP_MULTIPLIER = findDefaultStopMultiplier();
+static_assert(DEFAULT_STOP_MULTIPLIER != 0, "no perfect hash multiplier for the built-in stop words");
+
+// Slot table for the built-in stop words
+vector<unsigned long long> defaultStopFilter() {
+    vector<unsigned long long> filter(DEFAULT_STOP_TABLE_SIZE + 1, 0);
+    for (const char* word : DEFAULT_STOP_WORDS) {
+        unsigned long long hash = termHashOf(word, char_traits<char>::length(word));
+        filter[stopSlot(hash, DEFAULT_STOP_MULTIPLIER, DEFAULT_STOP_TABLE_SIZE)] = hash;
+    }
+    filter[DEFAULT_STOP_TABLE_SIZE] = DEFAULT_STOP_MULTIPLIER;
+    return filter;
+}
+
+// Slot table for a loaded word list. The table starts at 4 slots per word and
+// doubles whenever no multiplier in the search budget is collision-free.
+vector<unsigned long long> buildStopFilter(const vector<string>& words) {
+    vector<unsigned long long> hashes;
+    for (const string& w : words) hashes.push_back(termHash(w));
+    sort(hashes.begin(), hashes.end());
+    hashes.erase(unique(hashes.begin(), hashes.end()), hashes.end());
+
+    size_t tableSize = 16;
+    while (tableSize < hashes.size() * 4) tableSize *= 2;
+    vector<unsigned long long> filter;
+    while (true) {
+        for (int attempt = 0; attempt < 1000; ++attempt) {
+            unsigned long long multiplier = stopMultiplier(attempt);
+            filter.assign(tableSize + 1, 0);
+            bool perfect = true;
+            for (size_t i = 0; i < hashes.size() && perfect; ++i) {
+                size_t slot = stopSlot(hashes[i], multiplier, tableSize);
+                perfect = (filter[slot] == 0);
+                filter[slot] = hashes[i];
+            }
+            if (perfect) {
+                filter[tableSize] = multiplier;
+                return filter;
+            }
+        }
+        tableSize *= 2;
+    }
+}
+
+// True if a term hash belongs to the filter's word list
+inline bool isStopWord(unsigned long long hash, const vector<unsigned long long>& stopFilter) {
+    size_t tableSize = stopFilter.size() - 1;
+    return stopFilter[stopSlot(hash, stopFilter[tableSize], tableSize)] == hash;
+}
+
+// ---------------------------------------------------------------------------
+// Negation
+//
+// Shared by lexicon sentiment and alignment scoring. A token is negated when
+// a negator ("not", "no", "never" by default) appears within `window` tokens
+// on either side. Rather than rescanning that window for every token, the
+// tokenizer keeps a rolling bitmask of which recent tokens were negators and
+// holds each token back by `window` positions; when it is released the mask
+// covers both sides of it. Window 0 disables negation.
+// ---------------------------------------------------------------------------
+
+// Default negation words
+vector<string> defaultNegators() {
+    vector<string> negators;
+    negators.push_back("not"); negators.push_back("no"); negators.push_back("never");
+    return negators;
+}
+
+// Hashes the negator words so tokens are matched by hash instead of string compares
+vector<unsigned long long> negatorHashes(const vector<string>& negators) {
+    vector<unsigned long long> hashes;
+    for (const string& w : negators) hashes.push_back(termHash(w));
+    return hashes;
+}
+
+// Pushes the next token's negator flag into the mask (bit j = token j back).
+// Returns true if the token `window` positions back, which is now released,
+// has a negator on either side of it.
+constexpr bool advanceNegationWindow(unsigned long long& negMask, bool isNegator, int window) {
+    unsigned long long span = (2ULL << (2 * window)) - 1;
+    negMask = ((negMask << 1) | (isNegator ? 1 : 0)) & span;
+    return (negMask & ~(1ULL << window)) != 0;
+}
+
+// Releases the tokens still in the window at the end of a text of `count`
+// tokens. The window always shifts `window` times, so a text shorter than the
+// window still puts each token at bit `window` when it leaves; release(token,
+// negated) runs for every real token, in order.
+template <typename Release>
+constexpr void releaseNegationTail(unsigned long long& negMask, int count, int window, Release release) {
+    for (int k = 0; k < window; ++k) {
+        bool negated = advanceNegationWindow(negMask, false, window);
+        int ready = count - window + k;
+        if (ready >= 0) release(ready, negated);
+    }
+}
+
+// "not good" with a window of 3: both tokens leave in the tail, and "good"
+// must still come out negated
+constexpr bool shortTextNegated() {
+    unsigned long long negMask = 0;
+    advanceNegationWindow(negMask, true, 3);
+    advanceNegationWindow(negMask, false, 3);
+    bool goodNegated = false;
+    releaseNegationTail(negMask, 2, 3, [&](int token, bool negated) {
+        if (token == 1) goodNegated = negated;
+    });
+    return goodNegated;
+}
+static_assert(shortTextNegated(), "tokens of a text shorter than the negation window must still be negated");
+
+// ---------------------------------------------------------------------------
+// Weighted lexicon
+//
+// Lexicon entries are terms of one or more words with a score: positive
+// scores add to a text's positive total, negative scores (as magnitudes) to
+// its negative total. Entries are compiled into a trie over stemmed words.
+// Each edge is a slot in one open-addressing table keyed by a hash of
+// (parent node, stem hash), and each node holds the positive and negative
+// weight of the entry ending there. A text is matched left to right,
+// taking the longest entry that starts at each token, so a token costs a
+// single probe unless it begins a phrase. Entries that stem to the same
+// path keep the largest score, so the plain positive / negative word lists
+// (every word +1 or -1) count exactly as binary membership did. Weighted
+// files use the AFINN layout: one "term<TAB>score" per line.
+// ---------------------------------------------------------------------------
+
+// Reads a weighted lexicon file (term, tab, score per line; '#' comments)
+bool readWeightedLexicon(string path, vector<string>& terms, vector<double>& scores) {
+    ifstream in(path);
+    if (!in.is_open()) {
+        cerr << "Error: Could not open " << path << endl;
+        return false;
+    }
+    terms.clear();
+    scores.clear();
+    string line;
+    int lineNumber = 0;
+    while (getline(in, line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == '#') continue;
+        size_t tab = line.rfind('\t');
+        if (tab == string::npos || tab == 0) {
+            cerr << "Error: " << path << ":" << lineNumber << " expected term<TAB>score" << endl;
+            return false;
+        }
+        terms.push_back(line.substr(0, tab));
+        scores.push_back(atof(line.c_str() + tab + 1));
+    }
+    return true;
+}
+
+// The plain word lists as lexicon entries: +1 for positive, -1 for negative
+void lexiconFromWordLists(const vector<string>& positiveWords, const vector<string>& negativeWords,
+                          vector<string>& terms, vector<double>& scores) {
+    terms.clear();
+    scores.clear();
+    for (const string& w : positiveWords) {
+        terms.push_back(w);
+        scores.push_back(1.0);
+    }
+    for (const string& w : negativeWords) {
+        terms.push_back(w);
+        scores.push_back(-1.0);
+    }
+}
+
+// Hash of a stemmed word as the trie keys it
+inline unsigned long long lexiconStemHash(const string& stemmed) {
+    unsigned long long hash = fnv1aHash(stemmed, 0, stemmed.size());
+    return hash == 0 ? 1 : hash;
+}
+
+void compileLexicon(const vector<string>& terms, const vector<double>& scores, vector<unsigned long long>& trieKeys,
+                    vector<int>& trieChild, vector<double>& nodeWeights) {
+    size_t edges = 0;
+    for (const string& term : terms) {
+        stringstream ss(term);
+        string word;
+        while (ss >> word) edges++;
+    }
+    size_t size = 16;
+    while (size < edges * 2) size *= 2;
+    trieKeys.assign(size, 0);
+    trieChild.assign(size, -1);
+    nodeWeights.assign(2, 0.0);  // root
+
+    for (size_t i = 0; i < terms.size(); ++i) {
+        stringstream ss(terms[i]);
+        string word;
+        int node = 0;
+        bool any = false;
+        while (ss >> word) {
+            any = true;
+            unsigned long long key = ngramHash(static_cast<unsigned long long>(node) + 1, lexiconStemHash(stemToken(word)));
+            size_t slot = key & (size - 1);
+            while (trieKeys[slot] != 0 && trieKeys[slot] != key) slot = (slot + 1) & (size - 1);
+            if (trieKeys[slot] == 0) {
+                trieKeys[slot] = key;
+                trieChild[slot] = static_cast<int>(nodeWeights.size() / 2);
+                nodeWeights.push_back(0.0);
+                nodeWeights.push_back(0.0);
+            }
+            node = trieChild[slot];
+        }
+        if (!any) continue;
+        double& weight = nodeWeights[2 * node + (scores[i] > 0 ? 0 : 1)];
+        weight = max(weight, fabs(scores[i]));
+    }
+    METRIC_ADD(COUNTER_STEMS, static_cast<long long>(edges));
+}
+
+// Follows the edge for a stem from a trie node; -1 if there is none
+inline int lexiconStep(int node, unsigned long long stemHash, const vector<unsigned long long>& trieKeys, const vector<int>& trieChild) {
+    unsigned long long key = ngramHash(static_cast<unsigned long long>(node) + 1, stemHash);
+    size_t mask = trieKeys.size() - 1;
+    size_t slot = key & mask;
+    while (trieKeys[slot] != 0) {
+        if (trieKeys[slot] == key) return trieChild[slot];
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+// Sentiment totals as report text: integers stay integers ("156"), weighted
+// totals keep their fraction
+string formatReportScore(double value) {
+    ostringstream ss;
+    ss << setprecision(12) << value;
+    return ss.str();
+}
+
+// ---------------------------------------------------------------------------
+// Emoji channel
+//
+// Emoji are scored apart from the word lexicon. EMOJI_RANGES lists sorted,
+// disjoint code point ranges as (first, last, polarity) triples, 1 for
+// positive and -1 for negative; it is checked at compile time and searched
+// with a binary search, after one compare rules out everything below U+2600.
+// ASCII emoticons match whole tokens. Emoji are counted as they are, without
+// negation.
+// ---------------------------------------------------------------------------
+
+constexpr unsigned int EMOJI_RANGES[] = {
+    0x2639, 0x2639, static_cast<unsigned int>(-1),   // frowning face
+    0x263A, 0x263A, 1,                               // smiling face
+    0x2705, 0x2705, 1,                               // check mark
+    0x2728, 0x2728, 1,                               // sparkles
+    0x274C, 0x274C, static_cast<unsigned int>(-1),   // cross mark
+    0x2764, 0x2764, 1,                               // heart
+    0x1F389, 0x1F38A, 1,                             // party popper, confetti
+    0x1F44C, 0x1F44D, 1,                             // OK hand, thumbs up
+    0x1F44E, 0x1F44E, static_cast<unsigned int>(-1), // thumbs down
+    0x1F44F, 0x1F44F, 1,                             // clapping hands
+    0x1F493, 0x1F493, 1,                             // beating heart
+    0x1F494, 0x1F494, static_cast<unsigned int>(-1), // broken heart
+    0x1F495, 0x1F49F, 1,                             // hearts
+    0x1F4AA, 0x1F4AA, 1,                             // flexed biceps
+    0x1F600, 0x1F60E, 1,                             // grinning .. sunglasses
+    0x1F612, 0x1F616, static_cast<unsigned int>(-1), // unamused .. confounded
+    0x1F617, 0x1F61D, 1,                             // kissing .. tongue
+    0x1F61E, 0x1F62B, static_cast<unsigned int>(-1), // disappointed .. tired
+    0x1F62D, 0x1F62D, static_cast<unsigned int>(-1), // loudly crying
+    0x1F630, 0x1F631, static_cast<unsigned int>(-1), // anxious, screaming
+    0x1F64C, 0x1F64C, 1,                             // raising hands
+    0x1F64F, 0x1F64F, 1,                             // folded hands
+    0x1F923, 0x1F923, 1,                             // rolling on the floor laughing
+    0x1F92C, 0x1F92C, static_cast<unsigned int>(-1), // symbols on mouth
+    0x1F970, 0x1F970, 1,                             // smiling face with hearts
+    0x1F973, 0x1F973, 1,                             // partying face
+};
+constexpr int EMOJI_RANGE_COUNT = sizeof(EMOJI_RANGES) / sizeof(EMOJI_RANGES[0]) / 3;
+
+constexpr bool emojiRangesSorted() {
+    for (int i = 0; i < EMOJI_RANGE_COUNT; ++i) {
+        if (EMOJI_RANGES[3 * i] > EMOJI_RANGES[3 * i + 1]) return false;
+        if (i > 0 && EMOJI_RANGES[3 * i] <= EMOJI_RANGES[3 * i - 2]) return false;
+    }
+    return true;
+}
+static_assert(emojiRangesSorted(), "EMOJI_RANGES must be sorted and disjoint");
+
+// Polarity of a code point: 1 positive, -1 negative, 0 neither
+constexpr int emojiPolarity(unsigned int cp) {
+    if (cp < EMOJI_RANGES[0]) return 0;
+    int lo = 0;
+    int hi = EMOJI_RANGE_COUNT - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (cp < EMOJI_RANGES[3 * mid]) {
+            hi = mid - 1;
+        } else if (cp > EMOJI_RANGES[3 * mid + 1]) {
+            lo = mid + 1;
+        } else {
+            return static_cast<int>(EMOJI_RANGES[3 * mid + 2]);
+        }
+    }
+    return 0;
+}
+static_assert(emojiPolarity(0x1F44D) == 1 && emojiPolarity(0x1F621) == -1 && emojiPolarity(0x1F62C) == 0,
+              "emojiPolarity disagrees with EMOJI_RANGES");
+
+constexpr const char* POSITIVE_EMOTICONS[] = {":)", ":-)", ":D", ":-D", ";)", ";-)", "=)", ":P", ":-P", "<3"};
+constexpr const char* NEGATIVE_EMOTICONS[] = {":(", ":-(", ":'(", ">:(", "=(", ":/", ":-/", "</3"};
+
+// Adds a token's emoji and emoticons to the positive / negative counts.
+// ASCII tokens are only compared against the emoticons, and only when they
+// are short enough to be one.
+void countEmoji(const string& word, int& positive, int& negative) {
+    const char* p = word.data();
+    size_t n = word.size();
+    size_t i = asciiPrefixLength(p, n);
+    if (i == n) {
+        if (n > 3) return;
+        for (const char* emoticon : POSITIVE_EMOTICONS) {
+            if (word == emoticon) positive++;
+        }
+        for (const char* emoticon : NEGATIVE_EMOTICONS) {
+            if (word == emoticon) negative++;
+        }
+        return;
+    }
+    while (i < n) {
+        size_t length = 1;
+        int polarity = emojiPolarity(decodeUtf8(p + i, n - i, length));
+        if (polarity > 0) positive++;
+        if (polarity < 0) negative++;
+        i += length;
+        i += asciiPrefixLength(p + i, n - i);
+    }
+}
+
+// Counts the words of a text and adds its positive / negative lexicon
+// weights. A match's weight lands on its last token; when that token is
+// negated the positive and negative weights swap. Stop words still count as
+// words but are never looked up, and end any phrase.
+void scoreTextSentiment(const string& text, const vector<unsigned long long>& trieKeys, const vector<int>& trieChild,
+                        const vector<double>& nodeWeights, const vector<unsigned long long>& negHashes, int window,
+                        const vector<unsigned long long>& stopFilter, int& words, double& positive, double& negative,
+                        int& emojiPositive, int& emojiNegative) {
+    // 1. Stem hash (0 = not looked up) and negator flag per token; emoji are
+    //    counted from the same tokens
+    vector<unsigned long long> stemHashes;
+    vector<char> negatorFlags;
+    int stemmedCount = 0;
+    stringstream ss(text);
+    string word;
+    while (ss >> word) {
+        unsigned long long hash = termHash(word);
+        unsigned long long stemHash = 0;
+        if (!isStopWord(hash, stopFilter)) {
+            stemHash = lexiconStemHash(stemToken(word));
+            stemmedCount++;
+        }
+        stemHashes.push_back(stemHash);
+        negatorFlags.push_back(find(negHashes.begin(), negHashes.end(), hash) != negHashes.end());
+        countEmoji(word, emojiPositive, emojiNegative);
+    }
+    int count = static_cast<int>(stemHashes.size());
+    words += count;
+
+    long long hits = scoreLexiconMatches(stemHashes, negatorFlags, trieKeys, trieChild, nodeWeights, window, positive, negative);
+    METRIC_ADD(COUNTER_TOKENS, count);
+    METRIC_ADD(COUNTER_STEMS, stemmedCount);
+    METRIC_ADD(COUNTER_LEXICON_HITS, hits);
+}
+
+// Adds the lexicon weights of a tokenized text, given each token's stem hash
+// (0 = not looked up) and negator flag: the longest match starting at each
+// token puts its weight on its last token, swapped when that token is
+// negated. Shared by Part 1 and the inverted index. Returns the match count.
+long long scoreLexiconMatches(const vector<unsigned long long>& stemHashes, const vector<char>& negatorFlags,
+                              const vector<unsigned long long>& trieKeys, const vector<int>& trieChild,
+                              const vector<double>& nodeWeights, int window, double& positive, double& negative) {
+    int count = static_cast<int>(stemHashes.size());
+
+    // 1. Longest match starting at each token; weights go to the match's last token
+    vector<double> positiveAt(count, 0.0);
+    vector<double> negativeAt(count, 0.0);
+    long long hits = 0;
+    for (int i = 0; i < count;) {
+        int node = 0;
+        int matchEnd = -1;
+        int matchNode = 0;
+        for (int j = i; j < count && stemHashes[j] != 0; ++j) {
+            node = lexiconStep(node, stemHashes[j], trieKeys, trieChild);
+            if (node < 0) break;
+            if (nodeWeights[2 * node] != 0 || nodeWeights[2 * node + 1] != 0) {
+                matchEnd = j;
+                matchNode = node;
+            }
+        }
+        if (matchEnd < 0) {
+            i++;
+            continue;
+        }
+        positiveAt[matchEnd] = nodeWeights[2 * matchNode];
+        negativeAt[matchEnd] = nodeWeights[2 * matchNode + 1];
+        hits++;
+        i = matchEnd + 1;
+    }
+
+    // 2. Release each token once the `window` tokens after it are seen
+    unsigned long long negMask = 0;
+    for (int i = 0; i < count; ++i) {
+        bool negated = advanceNegationWindow(negMask, negatorFlags[i], window);
+        int ready = i - window;
+        if (ready < 0) continue;
+        positive += negated ? negativeAt[ready] : positiveAt[ready];
+        negative += negated ? positiveAt[ready] : negativeAt[ready];
+    }
+    // Release the last tokens; nothing follows them
+    releaseNegationTail(negMask, count, window, [&](int ready, bool negated) {
+        positive += negated ? negativeAt[ready] : positiveAt[ready];
+        negative += negated ? positiveAt[ready] : negativeAt[ready];
+    });
+    return hits;
+}
+
+// ---------------------------------------------------------------------------
+// Work-stealing pool
+//
+// Tweet volumes differ by two orders of magnitude between senators, so
+// per-senator work is not split by senator but into tasks of POOL_TASK_ROWS
+// consecutive tweets. Each worker starts with an equal run of tasks, kept as
+// [front, back) in one atomic word: the owner takes tasks from the front,
+// and a worker that runs dry steals single tasks from the back of the
+// others' runs. Both ends move by compare-and-swap on the same word, so
+// every task runs exactly once without locks. Tasks, steals and the busiest
+// and mean worker times go to the metrics; their ratio is the imbalance.
+// ---------------------------------------------------------------------------
+
+// Threads for a pool run: one per hardware thread, at most one per task
+int poolWorkers(int taskCount) {
+    int workers = static_cast<int>(thread::hardware_concurrency());
+    return max(1, min(workers, taskCount));
+}
+
+// Takes one task from a packed [front, back) run (front in the high half):
+// the front for its owner, the back for a thief. -1 if the run is empty
+int poolTake(atomic<unsigned long long>& range, bool fromBack) {
+    unsigned long long packed = range.load(memory_order_acquire);
+    while (true) {
+        unsigned int front = static_cast<unsigned int>(packed >> 32);
+        unsigned int back = static_cast<unsigned int>(packed);
+        if (front >= back) return -1;
+        unsigned long long next = fromBack ? packed - 1 : packed + (1ULL << 32);
+        if (range.compare_exchange_weak(packed, next, memory_order_acq_rel, memory_order_acquire)) {
+            return static_cast<int>(fromBack ? back - 1 : front);
+        }
+    }
+}
+
+// Runs task(worker, index) for every index in [0, taskCount) on the given
+// number of workers; the calling thread is worker 0. Each worker's run word
+// sits on its own cache line, so an owner taking from its front does not
+// contend with the CAS traffic on its neighbours' words.
+template <typename Task>
+void runStealingPool(int taskCount, int workers, Task task) {
+    const size_t rangeBytes = sizeof(atomic<unsigned long long>);
+    const size_t rangeStride = cacheLinePadded(1, rangeBytes);
+    vector<atomic<unsigned long long>> rangeTable(rangeStride * workers + CACHE_LINE_BYTES / rangeBytes);
+    atomic<unsigned long long>* ranges = &rangeTable[cacheLineOffset(rangeTable.data(), rangeBytes)];
+    for (int w = 0; w < workers; ++w) {
+        unsigned long long front = static_cast<unsigned long long>(taskCount) * w / workers;
+        unsigned long long back = static_cast<unsigned long long>(taskCount) * (w + 1) / workers;
+        ranges[w * rangeStride].store((front << 32) | back, memory_order_relaxed);
+    }
+    vector<long long> busyNanos(workers, 0);
+    vector<long long> steals(workers, 0);
+    auto work = [&](int w) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        long long stolen = 0;
+        while (true) {
+            int t = poolTake(ranges[w * rangeStride], false);
+            for (int k = 1; t < 0 && k < workers; ++k) {
+                t = poolTake(ranges[((w + k) % workers) * rangeStride], true);
+                if (t >= 0) stolen++;
+            }
+            if (t < 0) break;
+            task(w, t);
+        }
+        steals[w] = stolen;
+        busyNanos[w] = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    };
+    vector<thread> pool;
+    for (int w = 1; w < workers; ++w) pool.push_back(thread(work, w));
+    work(0);
+    for (thread& worker : pool) worker.join();
+
+    long long maxNanos = 0;
+    long long sumNanos = 0;
+    long long stolen = 0;
+    for (int w = 0; w < workers; ++w) {
+        maxNanos = max(maxNanos, busyNanos[w]);
+        sumNanos += busyNanos[w];
+        stolen += steals[w];
+    }
+    METRIC_ADD(COUNTER_POOL_TASKS, static_cast<long long>(taskCount));
+    METRIC_ADD(COUNTER_POOL_STEALS, stolen);
+    METRIC_ADD(COUNTER_POOL_BUSY_MAX_US, maxNanos / 1000);
+    METRIC_ADD(COUNTER_POOL_BUSY_MEAN_US, sumNanos / workers / 1000);
+}
+
+// ---------------------------------------------------------------------------
+// Per-senator accumulators
+//
+// Counters that pool workers update are kept in structure-of-arrays tables:
+// one int (or double) column per statistic, indexed by senator and padded to
+// whole cache lines, and one replica of every column per worker, starting on
+// a cache line. A worker never writes a line another worker writes, so replicas do
+// not false-share, and the replicas are summed a line at a time in a loop
+// the compiler turns into vector adds.
+// ---------------------------------------------------------------------------
+
+// count elements of elementBytes each, rounded up to whole cache lines
+size_t cacheLinePadded(size_t count, size_t elementBytes) {
+    size_t perLine = CACHE_LINE_BYTES / elementBytes;
+    return (count + perLine - 1) / perLine * perLine;
+}
+
+// Elements to skip from data to reach a cache line boundary
+size_t cacheLineOffset(const void* data, size_t elementBytes) {
+    size_t misalign = reinterpret_cast<size_t>(data) % CACHE_LINE_BYTES;
+    return misalign == 0 ? 0 : (CACHE_LINE_BYTES - misalign) / elementBytes;
+}
+
+// Zeroes a table of `columns` columns per worker; returns the offset of its
+// first element, which starts on a cache line
+template <typename T>
+size_t initAccumulators(vector<T>& table, int workers, int columns, size_t senators) {
+    size_t replica = static_cast<size_t>(columns) * cacheLinePadded(senators, sizeof(T));
+    table.assign(replica * workers + CACHE_LINE_BYTES / sizeof(T), 0);
+    return cacheLineOffset(table.data(), sizeof(T));
+}
+
+// A worker's column, indexed by senator
+template <typename T>
+T* accumulatorColumn(vector<T>& table, size_t base, int worker, int column, int columns, size_t senators) {
+    size_t stride = cacheLinePadded(senators, sizeof(T));
+    return &table[base + (static_cast<size_t>(worker) * columns + column) * stride];
+}
+
+// Adds whole cache lines of part into total
+template <typename T>
+void addAccumulatorLines(T* __restrict total, const T* __restrict part, size_t lines) {
+    const size_t perLine = CACHE_LINE_BYTES / sizeof(T);
+    for (size_t line = 0; line < lines; ++line) {
+        for (size_t k = 0; k < perLine; ++k) total[line * perLine + k] += part[line * perLine + k];
+    }
+}
+
+// Sums every worker's replica into worker 0's
+template <typename T>
+void mergeAccumulators(vector<T>& table, size_t base, int workers, int columns, size_t senators) {
+    size_t replica = static_cast<size_t>(columns) * cacheLinePadded(senators, sizeof(T));
+    for (int w = 1; w < workers; ++w) {
+        addAccumulatorLines(&table[base], &table[base + w * replica], replica / (CACHE_LINE_BYTES / sizeof(T)));
+    }
+}
+
+// Adds value to a compensated (Kahan) sum; lost carries the low-order bits
+// the running sum dropped, to be subtracted when the sum is read
+inline void kahanAdd(double& sum, double& lost, double value) {
+    double y = value - lost;
+    double t = sum + y;
+    lost = (t - sum) - y;
+    sum = t;
+}
+
+// Part 1 aggregate: per-senator tweets, words, lexicon totals and emoji
+// counts, indexed like senators, in one pass over the tweets
+void aggregateSenatorSentiment(const vector<vector<string>>& tweets, const vector<string>& senators, const vector<string>& lexiconTerms,
+                               const vector<double>& lexiconScores, const vector<string>& negators, int negationWindow,
+                               const vector<unsigned long long>& stopFilter, vector<int>& senTweets, vector<int>& senWords,
+                               vector<double>& senPositive, vector<double>& senNegative, vector<int>& senEmojiPositive,
+                               vector<int>& senEmojiNegative) {
+    // Compile the lexicon into the stem trie
+    vector<unsigned long long> trieKeys;
+    vector<int> trieChild;
+    vector<double> nodeWeights;
+    compileLexicon(lexiconTerms, lexiconScores, trieKeys, trieChild, nodeWeights);
+    vector<unsigned long long> negHashes = negatorHashes(negators);
+
+    // Counts go to per-worker int accumulators; lexicon totals to per-worker
+    // double accumulators holding compensated sums (total, lost bits), so
+    // the totals barely depend on which worker ran what
+    size_t senatorCount = senators.size();
+    int tasks = static_cast<int>((tweets.size() + POOL_TASK_ROWS - 1) / POOL_TASK_ROWS);
+    int workers = poolWorkers(tasks);
+    vector<int> counts;
+    size_t countBase = initAccumulators(counts, workers, 4, senatorCount);
+    vector<double> totals;
+    size_t totalBase = initAccumulators(totals, workers, 4, senatorCount);
+    runStealingPool(tasks, workers, [&](int w, int t) {
+        int* tweetCounts = accumulatorColumn(counts, countBase, w, 0, 4, senatorCount);
+        int* wordCounts = accumulatorColumn(counts, countBase, w, 1, 4, senatorCount);
+        int* emojiPositive = accumulatorColumn(counts, countBase, w, 2, 4, senatorCount);
+        int* emojiNegative = accumulatorColumn(counts, countBase, w, 3, 4, senatorCount);
+        double* positive = accumulatorColumn(totals, totalBase, w, 0, 4, senatorCount);
+        double* positiveLost = accumulatorColumn(totals, totalBase, w, 1, 4, senatorCount);
+        double* negative = accumulatorColumn(totals, totalBase, w, 2, 4, senatorCount);
+        double* negativeLost = accumulatorColumn(totals, totalBase, w, 3, 4, senatorCount);
+        size_t rowEnd = min(tweets.size(), static_cast<size_t>(t + 1) * POOL_TASK_ROWS);
+        for (size_t r = static_cast<size_t>(t) * POOL_TASK_ROWS; r < rowEnd; ++r) {
+            const vector<string>& row = tweets[r];
+            size_t s = lower_bound(senators.begin(), senators.end(), row[3]) - senators.begin();
+            if (s >= senatorCount || senators[s] != row[3]) continue;
+            tweetCounts[s]++;
+            double tweetPositive = 0, tweetNegative = 0;
+            scoreTextSentiment(row[4], trieKeys, trieChild, nodeWeights, negHashes, negationWindow, stopFilter, wordCounts[s],
+                               tweetPositive, tweetNegative, emojiPositive[s], emojiNegative[s]);
+            kahanAdd(positive[s], positiveLost[s], tweetPositive);
+            kahanAdd(negative[s], negativeLost[s], tweetNegative);
+        }
+    });
+    mergeAccumulators(counts, countBase, workers, 4, senatorCount);
+    mergeAccumulators(totals, totalBase, workers, 4, senatorCount);
+
+    const int* tweetCounts = accumulatorColumn(counts, countBase, 0, 0, 4, senatorCount);
+    const int* wordCounts = accumulatorColumn(counts, countBase, 0, 1, 4, senatorCount);
+    const int* emojiPositive = accumulatorColumn(counts, countBase, 0, 2, 4, senatorCount);
+    const int* emojiNegative = accumulatorColumn(counts, countBase, 0, 3, 4, senatorCount);
+    senTweets.assign(tweetCounts, tweetCounts + senatorCount);
+    senWords.assign(wordCounts, wordCounts + senatorCount);
+    senEmojiPositive.assign(emojiPositive, emojiPositive + senatorCount);
+    senEmojiNegative.assign(emojiNegative, emojiNegative + senatorCount);
+    const double* positive = accumulatorColumn(totals, totalBase, 0, 0, 4, senatorCount);
+    const double* positiveLost = accumulatorColumn(totals, totalBase, 0, 1, 4, senatorCount);
+    const double* negative = accumulatorColumn(totals, totalBase, 0, 2, 4, senatorCount);
+    const double* negativeLost = accumulatorColumn(totals, totalBase, 0, 3, 4, senatorCount);
+    senPositive.resize(senatorCount);
+    senNegative.resize(senatorCount);
+    for (size_t s = 0; s < senatorCount; ++s) {
+        senPositive[s] = positive[s] - positiveLost[s];
+        senNegative[s] = negative[s] - negativeLost[s];
+    }
+}
+
+// Part 1 report: sentiment percentages per senator
+void reportSentiment(const vector<string>& senators, const vector<int>& senWords, const vector<double>& senPositive,
+                     const vector<double>& senNegative, const vector<int>& senEmojiPositive, const vector<int>& senEmojiNegative,
+                     ostream& out, ReportFormat format) {
+    vector<vector<string>> records;
+
+    if (format == REPORT_TABLE) {
+        out << left << setw(20) << "Senator" << right << setw(15) << "Positive %" << setw(15) << "Negative %"
+            << setw(10) << "Emoji +" << setw(10) << "Emoji -" << '\n';
+        out << string(70, '-') << '\n';
+    }
+
+    for (size_t s = 0; s < senators.size(); ++s) {
+        double posPct = (senWords[s] > 0) ? senPositive[s] / senWords[s] * 100.0 : 0.0;
+        double negPct = (senWords[s] > 0) ? senNegative[s] / senWords[s] * 100.0 : 0.0;
+
+        if (format == REPORT_TABLE) {
+            out << left << setw(20) << senators[s] << right << setw(15) << fixed << setprecision(5) << posPct << setw(15) << negPct
+                << setw(10) << senEmojiPositive[s] << setw(10) << senEmojiNegative[s] << '\n';
+        }
+        records.push_back({senators[s], getParty(senators[s]), to_string(senWords[s]), formatReportScore(senPositive[s]),
+                           formatReportScore(senNegative[s]), formatReportNumber(posPct, 5), formatReportNumber(negPct, 5),
+                           to_string(senEmojiPositive[s]), to_string(senEmojiNegative[s])});
+    }
+    if (format != REPORT_TABLE) {
+        writeReportSection(out, format, "sentiment", {"senator", "party", "words", "positive", "negative", "positive_pct", "negative_pct",
+                                                      "emoji_positive", "emoji_negative"},
+                           "ssiddddii", records);
+    }
+}
+
+// Part 1: Calculates and prints sentiment percentages
+void calculateSentiment(const vector<vector<string>>& tweets, const vector<string>& senators, const vector<string>& lexiconTerms,
+                        const vector<double>& lexiconScores, const vector<string>& negators, int negationWindow,
+                        const vector<unsigned long long>& stopFilter, ostream& out, ReportFormat format) {
+    vector<int> senTweets, senWords, senEmojiPositive, senEmojiNegative;
+    vector<double> senPositive, senNegative;
+    aggregateSenatorSentiment(tweets, senators, lexiconTerms, lexiconScores, negators, negationWindow, stopFilter, senTweets, senWords,
+                              senPositive, senNegative, senEmojiPositive, senEmojiNegative);
+    reportSentiment(senators, senWords, senPositive, senNegative, senEmojiPositive, senEmojiNegative, out, format);
+}
+
+// Part 2 aggregate: tweets and words per senator, indexed like senators
+void countSenatorWords(const vector<vector<string>>& tweets, const vector<string>& senators, vector<int>& senTweets, vector<int>& senWords) {
+    size_t senatorCount = senators.size();
+    int tasks = static_cast<int>((tweets.size() + POOL_TASK_ROWS - 1) / POOL_TASK_ROWS);
+    int workers = poolWorkers(tasks);
+    vector<int> counts;
+    size_t base = initAccumulators(counts, workers, 2, senatorCount);
+    runStealingPool(tasks, workers, [&](int w, int t) {
+        int* tweetCounts = accumulatorColumn(counts, base, w, 0, 2, senatorCount);
+        int* wordCounts = accumulatorColumn(counts, base, w, 1, 2, senatorCount);
+        size_t rowEnd = min(tweets.size(), static_cast<size_t>(t + 1) * POOL_TASK_ROWS);
+        for (size_t r = static_cast<size_t>(t) * POOL_TASK_ROWS; r < rowEnd; ++r) {
+            const vector<string>& row = tweets[r];
+            size_t s = lower_bound(senators.begin(), senators.end(), row[3]) - senators.begin();
+            if (s >= senatorCount || senators[s] != row[3]) continue;
+            tweetCounts[s]++;
+            stringstream ss(row[4]);
+            string word;
+            while (ss >> word) {
+                wordCounts[s]++;
+            }
+        }
+    });
+    mergeAccumulators(counts, base, workers, 2, senatorCount);
+
+    const int* tweetCounts = accumulatorColumn(counts, base, 0, 0, 2, senatorCount);
+    const int* wordCounts = accumulatorColumn(counts, base, 0, 1, 2, senatorCount);
+    senTweets.assign(tweetCounts, tweetCounts + senatorCount);
+    senWords.assign(wordCounts, wordCounts + senatorCount);
+}
+
+// Part 2 - Capability 1 report: Most Talkative Senator
+void reportMostTalkative(const vector<string>& senators, const vector<int>& senTweets, const vector<int>& senWords,
+                         ostream& out, ReportFormat format) {
+    string mostTweetsSenator;
+    int maxTweets = -1;
+
+    string mostWordsSenator;
+    double maxAvgWords = -1.0;
+    vector<vector<string>> records;
+
+    if (format == REPORT_TABLE) {
+        out << left << setw(20) << "Senator" << right << setw(15) << "Tweet Count" << setw(20) << "Avg Words/Tweet" << '\n';
+    }
+
+    for (size_t s = 0; s < senators.size(); ++s) {
+        int tweetCount = senTweets[s];
+        int totalWords = senWords[s];
+        double avgWords = (tweetCount > 0) ? static_cast<double>(totalWords) / tweetCount : 0.0;
+
+        if (format == REPORT_TABLE) {
+            out << left << setw(20) << senators[s] << right << setw(15) << tweetCount << setw(20) << fixed << setprecision(2) << avgWords << '\n';
+        }
+        records.push_back({senators[s], getParty(senators[s]), to_string(tweetCount), to_string(totalWords), formatReportNumber(avgWords, 2)});
+
+        if (tweetCount > maxTweets) {
+            maxTweets = tweetCount;
+            mostTweetsSenator = senators[s];
+        }
+        if (avgWords > maxAvgWords) {
+            maxAvgWords = avgWords;
+            mostWordsSenator = senators[s];
+        }
+    }
+
+    if (format == REPORT_TABLE) {
+        out << '\n';
+        out << "Most tweets: " << mostTweetsSenator << " (" << maxTweets << ")" << '\n';
+        out << "Highest average word count: " << mostWordsSenator << " (" << maxAvgWords << ")" << '\n';
+    } else {
+        writeReportSection(out, format, "talkative", {"senator", "party", "tweets", "words", "avg_words"}, "ssiid", records);
+    }
+}
+
+// Part 2 - Capability 1: Most Talkative Senator
+void findMostTalkative(const vector<vector<string>>& tweets, const vector<string>& senators, ostream& out, ReportFormat format) {
+    vector<int> senTweets, senWords;
+    countSenatorWords(tweets, senators, senTweets, senWords);
+    reportMostTalkative(senators, senTweets, senWords, out, format);
+}
+
+// Part 2 - Capability 2 aggregate: tweets mentioning Biden and their sentiment totals
+void aggregateBidenSentiment(const vector<vector<string>>& tweets, const vector<string>& lexiconTerms, const vector<double>& lexiconScores,
+                             const vector<string>& negators, int negationWindow, const vector<unsigned long long>& stopFilter,
+                             int& bidenTweetCount, int& totalWords, double& posCount, double& negCount) {
+    // Compile the lexicon into the stem trie
+    vector<unsigned long long> trieKeys;
+    vector<int> trieChild;
+    vector<double> nodeWeights;
+    compileLexicon(lexiconTerms, lexiconScores, trieKeys, trieChild, nodeWeights);
+    vector<unsigned long long> negHashes = negatorHashes(negators);
+
+    int emojiPos = 0;  // only reported per senator
+    int emojiNeg = 0;
+    for (const auto& row : tweets) {
+        const string& text = row[4];
+        // Case-insensitive check for "Biden"
+        string lowerText = normalizeUtf8(text);
+
+        if (lowerText.find("biden") != string::npos) {
+            bidenTweetCount++;
+            scoreTextSentiment(text, trieKeys, trieChild, nodeWeights, negHashes, negationWindow, stopFilter, totalWords, posCount, negCount,
+                               emojiPos, emojiNeg);
+        }
+    }
+}
+
+// Part 2 - Capability 2 report: Biden Sentiment
+void reportBidenSentiment(int bidenTweetCount, int totalWords, double posCount, double negCount, ostream& out, ReportFormat format) {
+    double posPct = (totalWords > 0) ? posCount / totalWords * 100.0 : 0.0;
+    double negPct = (totalWords > 0) ? negCount / totalWords * 100.0 : 0.0;
+    string conclusion = (posPct > negPct) ? "POSITIVE" : (negPct > posPct) ? "NEGATIVE" : "NEUTRAL";
+    if (format != REPORT_TABLE) {
+        writeReportSection(out, format, "biden", {"tweets", "words", "positive", "negative", "positive_pct", "negative_pct", "conclusion"},
+                           "iidddds", {{to_string(bidenTweetCount), to_string(totalWords), formatReportScore(posCount), formatReportScore(negCount),
+                                        formatReportNumber(posPct, 5), formatReportNumber(negPct, 5), conclusion}});
+        return;
+    }
+
+    out << "Found " << bidenTweetCount << " tweets mentioning Biden." << '\n';
+    if (totalWords > 0) {
+        out << "Positive %: " << posPct << '\n';
+        out << "Negative %: " << negPct << '\n';
+        
+        if (conclusion == "NEUTRAL") {
+            out << "Conclusion: Tweets about Biden are NEUTRAL." << '\n';
+        } else {
+            out << "Conclusion: Tweets about Biden are mostly " << conclusion << "." << '\n';
+        }
+    } else {
+        out << "No words found in Biden tweets." << '\n';
+    }
+}
+
+// Part 2 - Capability 2: Biden Sentiment
+void analyzeBidenSentiment(const vector<vector<string>>& tweets, const vector<string>& lexiconTerms, const vector<double>& lexiconScores,
+                           const vector<string>& negators, int negationWindow, const vector<unsigned long long>& stopFilter,
+                           ostream& out, ReportFormat format) {
+    int bidenTweetCount = 0;
+    int totalWords = 0;
+    double posCount = 0;
+    double negCount = 0;
+    aggregateBidenSentiment(tweets, lexiconTerms, lexiconScores, negators, negationWindow, stopFilter, bidenTweetCount, totalWords,
+                            posCount, negCount);
+    reportBidenSentiment(bidenTweetCount, totalWords, posCount, negCount, out, format);
+}
+
+// Combines the hash of an n-gram prefix with the hash of its next token
+inline unsigned long long ngramHash(unsigned long long prefix, unsigned long long token) {
+    unsigned long long h = (prefix ^ (token + 0x9E3779B97F4A7C15ULL + (prefix << 6) + (prefix >> 2))) * 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return h == 0 ? 1 : h;
+}
+
+// Hash of a space-separated phrase: termHash for one word, chained ngramHash for more
+unsigned long long phraseHash(const string& phrase) {
+    stringstream ss(phrase);
+    string word;
+    unsigned long long hash = 0;
+    bool first = true;
+    while (ss >> word) {
+        hash = first ? termHash(word) : ngramHash(hash, termHash(word));
+        first = false;
+    }
+    return first ? termHash("") : hash;
+}
+
+// Picks the 15 most Republican and then the 15 most Democrat candidates by
+// count difference, among candidates used more than 5 times; ties go to the
+// earlier candidate. Returns candidate indexes and their parties.
+void selectKeyTerms(const vector<int>& candRep, const vector<int>& candDem, vector<int>& picks, vector<string>& pickParty) {
+    picks.clear();
+    pickParty.clear();
+    vector<char> picked(candRep.size(), 0);
+    
+    for (int side = 0; side < 2; ++side) {
+        // side 0 finds the top Republican terms, side 1 the top Democrat terms
+        for (int k = 0; k < 15; ++k) {
+            int maxDiff = -1;
+            int bestIdx = -1;
+            for (size_t i = 0; i < candRep.size(); ++i) {
+                int diff = (side == 0) ? candRep[i] - candDem[i] : candDem[i] - candRep[i];
+                if (!picked[i] && diff > maxDiff && (candRep[i] + candDem[i] > 5)) {
+                    maxDiff = diff;
+                    bestIdx = static_cast<int>(i);
+                }
+            }
+            if (bestIdx == -1) continue;
+            picked[bestIdx] = 1;
+            picks.push_back(bestIdx);
+            pickParty.push_back(side == 0 ? "Republican" : "Democrat");
+        }
+    }
+}
+
+// Key terms from single-word vocabulary counts (as merged from partials)
+void keyTermsFromCounts(const vector<string>& vocab, const vector<int>& repCounts, const vector<int>& demCounts,
+                        vector<string>& keyTerms, vector<string>& keyTermParty) {
+    vector<int> picks;
+    selectKeyTerms(repCounts, demCounts, picks, keyTermParty);
+    keyTerms.clear();
+    for (int i : picks) keyTerms.push_back(vocab[i]);
+}
+
+// Builds the party vocabulary counts from the tweets and picks the 15 most
+// Republican and 15 most Democrat terms as key terms. With maxNgram > 1,
+// runs of 2..maxNgram consecutive vocabulary words are counted as well, keyed
+// by a rolling hash of their word hashes in a fixed-size open-addressing
+// table, and compete with single words for the key term slots. Once the
+// table is three-quarters full new phrases are no longer admitted, so memory
+// stays bounded however large the corpus is.
+void trainAlignmentModel(const vector<vector<string>>& tweets, const vector<unsigned long long>& stopFilter,
+                         vector<string>& keyTerms, vector<string>& keyTermParty, int maxNgram) {
+    vector<string> vocab;
+    vector<int> repCounts, demCounts;
+    trainAlignmentModel(tweets, stopFilter, keyTerms, keyTermParty, maxNgram, vocab, repCounts, demCounts);
+}
+
+// As above, also returning the single-word vocabulary (first-seen order)
+// and its per-party counts
+void trainAlignmentModel(const vector<vector<string>>& tweets, const vector<unsigned long long>& stopFilter,
+                         vector<string>& keyTerms, vector<string>& keyTermParty, int maxNgram,
+                         vector<string>& vocab, vector<int>& repCounts, vector<int>& demCounts) {
+    METRIC_TIMER_BEGIN(TIMER_ALIGNMENT_TRAIN);
+    // 1. Build Vocabulary and Counts
+    vector<int> vocabTable;
+    vector<unsigned long long> vocabHash;
+    vocab.clear();
+    repCounts.clear();
+    demCounts.clear();
+    
+    // Phrase count table (only allocated when phrases are requested)
+    size_t phraseSlots = (maxNgram > 1) ? NGRAM_TABLE_SLOTS : 0;
+    vector<unsigned long long> phraseKeys(phraseSlots, 0);
+    vector<int> phraseRep(phraseSlots, 0);
+    vector<int> phraseDem(phraseSlots, 0);
+    vector<int> phraseWords(phraseSlots * MAX_NGRAM, -1);
+    size_t phrasesUsed = 0;
+    long long phrasesDropped = 0;
+    long long tokensSeen = 0;
+
+    for (const auto& row : tweets) {
+        if (row.size() < 5) continue;
+        bool republican = (getParty(row[3]) == "Republican");
+        string text = row[4];
+
+        // Vocabulary ids of the most recent run of consecutive kept words
+        int run[MAX_NGRAM];
+        int runLength = 0;
+        
+        stringstream ss(text);
+        string word;
+        while (ss >> word) {
+            tokensSeen++;
+            string clean = cleanWord(word);
+            if (clean.length() < 3 || isStopWord(termHash(clean), stopFilter)) {
+                runLength = 0;
+                continue;
+            }
+
+            int index = internString(clean, vocab, vocabTable);
+            if (index == static_cast<int>(repCounts.size())) {
+                vocabHash.push_back(termHash(clean));
+                repCounts.push_back(0);
+                demCounts.push_back(0);
+            }
+            (republican ? repCounts : demCounts)[index]++;
+
+            if (phraseSlots == 0) continue;
+            if (runLength == maxNgram) {
+                for (int k = 1; k < runLength; ++k) run[k - 1] = run[k];
+                runLength--;
+            }
+            run[runLength++] = index;
+
+            // Count every phrase that ends at this word
+            for (int len = 2; len <= runLength; ++len) {
+                int first = runLength - len;
+                unsigned long long key = vocabHash[run[first]];
+                for (int k = first + 1; k < runLength; ++k) key = ngramHash(key, vocabHash[run[k]]);
+
+                size_t slot = key & (phraseSlots - 1);
+                while (phraseKeys[slot] != 0 && phraseKeys[slot] != key) slot = (slot + 1) & (phraseSlots - 1);
+                if (phraseKeys[slot] == 0) {
+                    if (phrasesUsed * 4 >= phraseSlots * 3) {
+                        phrasesDropped++;
+                        continue;
+                    }
+                    phraseKeys[slot] = key;
+                    for (int k = 0; k < len; ++k) phraseWords[slot * MAX_NGRAM + k] = run[first + k];
+                    phrasesUsed++;
+                }
+                (republican ? phraseRep : phraseDem)[slot]++;
+            }
+        }
+    }
+    if (phrasesDropped > 0) {
+        cerr << "Warning: phrase table full, " << phrasesDropped << " phrase occurrences were not counted" << endl;
+    }
+
+    // Candidates: every vocabulary word in first-seen order, then every phrase
+    vector<int> candRep(repCounts);
+    vector<int> candDem(demCounts);
+    vector<size_t> candSlot(vocab.size(), 0);
+    for (size_t slot = 0; slot < phraseSlots; ++slot) {
+        if (phraseKeys[slot] == 0) continue;
+        candRep.push_back(phraseRep[slot]);
+        candDem.push_back(phraseDem[slot]);
+        candSlot.push_back(slot);
+    }
+
+    // 2. Identify Key Terms
+    vector<int> picks;
+    selectKeyTerms(candRep, candDem, picks, keyTermParty);
+    keyTerms.clear();
+    for (int bestIdx : picks) {
+        string term;
+        if (static_cast<size_t>(bestIdx) < vocab.size()) {
+            term = vocab[bestIdx];
+        } else {
+            size_t slot = candSlot[bestIdx];
+            for (int w = 0; w < MAX_NGRAM && phraseWords[slot * MAX_NGRAM + w] >= 0; ++w) {
+                term += (w > 0 ? " " : "") + vocab[phraseWords[slot * MAX_NGRAM + w]];
+            }
+        }
+        keyTerms.push_back(term);
+    }
+    METRIC_ADD(COUNTER_TOKENS, tokensSeen);
+    METRIC_SET(COUNTER_VOCAB_SIZE, static_cast<long long>(vocab.size()));
+    METRIC_TIMER_END(TIMER_ALIGNMENT_TRAIN);
+}
+
+// Freezes a trained model into an open-addressing table keyed by term hash
+// (phraseHash for multi-word terms). Each slot holds the term weight and flags
+// (bit 0 = scoring term, bit 1 = negator, bit 2 = word of some phrase term)
+// so scoring a token is a single probe sequence; phrase hashes are only
+// probed while consecutive tokens all carry bit 2.
+void buildAlignmentScorer(const vector<string>& terms, const vector<double>& weights, const vector<string>& negators,
+                          vector<unsigned long long>& scorerKeys, vector<double>& scorerWeights, vector<unsigned char>& scorerFlags) {
+    // Entries: (key, weight, flags)
+    vector<unsigned long long> keys;
+    vector<double> entryWeights;
+    vector<unsigned char> entryFlags;
+    for (size_t i = 0; i < terms.size(); ++i) {
+        keys.push_back(phraseHash(terms[i]));
+        entryWeights.push_back(weights[i]);
+        entryFlags.push_back(1);
+        if (terms[i].find(' ') != string::npos) {
+            stringstream ss(terms[i]);
+            string word;
+            while (ss >> word) {
+                keys.push_back(termHash(word));
+                entryWeights.push_back(0.0);
+                entryFlags.push_back(4);
+            }
+        }
+    }
+    for (const string& w : negators) {
+        keys.push_back(termHash(w));
+        entryWeights.push_back(0.0);
+        entryFlags.push_back(2);
+    }
+
+    size_t size = 16;
+    while (size < keys.size() * 4) size *= 2;
+    scorerKeys.assign(size, 0);
+    scorerWeights.assign(size, 0.0);
+    scorerFlags.assign(size, 0);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        size_t slot = keys[i] & (size - 1);
+        while (scorerKeys[slot] != 0 && scorerKeys[slot] != keys[i]) slot = (slot + 1) & (size - 1);
+        scorerKeys[slot] = keys[i];
+        scorerWeights[slot] += entryWeights[i];
+        scorerFlags[slot] |= entryFlags[i];
+    }
+}
+
+// Returns the scorer slot for a term hash, or -1 if the term is not in the model
+long long findScorerSlot(const vector<unsigned long long>& scorerKeys, unsigned long long key) {
+    size_t mask = scorerKeys.size() - 1;
+    size_t slot = key & mask;
+    while (scorerKeys[slot] != 0) {
+        if (scorerKeys[slot] == key) return static_cast<long long>(slot);
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+// Scores text with a frozen model: the sum of term weights, each flipped when
+// a negator is within negationWindow tokens of the term's last word. The text
+// is hashed token by token in place, so scoring allocates nothing. Returns 1
+// (Republican), -1 (Democrat) or 0.
+int predictWithScorer(const string& text, const vector<unsigned long long>& scorerKeys,
+                      const vector<double>& scorerWeights, const vector<unsigned char>& scorerFlags, int negationWindow) {
+    // Scorer slots of the terms ending at each token not yet released (-1 = none)
+    long long pending[MAX_NEGATION_WINDOW + 1][MAX_NGRAM];
+    unsigned long long negMask = 0;
+    int ringSize = negationWindow + 1;
+    int count = 0;
+    double score = 0;
+    int termsFound = 0;
+
+    // Hashes of the preceding tokens that are words of phrase terms
+    unsigned long long phrasePrev[MAX_NGRAM];
+    int phraseRun = 0;
+
+    size_t pos = 0;
+    size_t n = text.size();
+    while (true) {
+        while (pos < n && isTokenSpace(text[pos])) pos++;
+        if (pos >= n) break;
+        unsigned long long hash = 1469598103934665603ULL;
+        while (pos < n && !isTokenSpace(text[pos])) pos += hashTermChar(text.data() + pos, n - pos, hash);
+        if (hash == 0) hash = 1;
+        long long slot = findScorerSlot(scorerKeys, hash);
+        unsigned char flags = (slot >= 0) ? scorerFlags[slot] : 0;
+
+        long long* ends = pending[count % ringSize];
+        for (int k = 0; k < MAX_NGRAM; ++k) ends[k] = -1;
+        if (flags & 1) ends[0] = slot;
+
+        // Phrases ending here: chain the hashes of the preceding phrase words
+        if (flags & 4) {
+            unsigned long long key = hash;
+            for (int len = 2; len <= phraseRun + 1; ++len) {
+                // Rebuild the phrase hash from its first word forward
+                key = phrasePrev[phraseRun - len + 1];
+                for (int k = phraseRun - len + 2; k < phraseRun; ++k) key = ngramHash(key, phrasePrev[k]);
+                key = ngramHash(key, hash);
+                long long phraseSlot = findScorerSlot(scorerKeys, key);
+                if (phraseSlot >= 0 && (scorerFlags[phraseSlot] & 1)) ends[len - 1] = phraseSlot;
+            }
+            if (phraseRun == MAX_NGRAM - 1) {
+                for (int k = 1; k < phraseRun; ++k) phrasePrev[k - 1] = phrasePrev[k];
+                phraseRun--;
+            }
+            phrasePrev[phraseRun++] = hash;
+        } else {
+            phraseRun = 0;
+        }
+        count++;
+
+        bool negated = advanceNegationWindow(negMask, flags & 2, negationWindow);
+        int ready = count - 1 - negationWindow;
+        for (int k = 0; ready >= 0 && k < MAX_NGRAM; ++k) {
+            long long termSlot = pending[ready % ringSize][k];
+            if (termSlot < 0) continue;
+            score += negated ? -scorerWeights[termSlot] : scorerWeights[termSlot];
+            termsFound++;
+        }
+    }
+    // Release the last tokens; nothing follows them
+    releaseNegationTail(negMask, count, negationWindow, [&](int ready, bool negated) {
+        for (int k = 0; k < MAX_NGRAM; ++k) {
+            long long termSlot = pending[ready % ringSize][k];
+            if (termSlot < 0) continue;
+            score += negated ? -scorerWeights[termSlot] : scorerWeights[termSlot];
+            termsFound++;
+        }
+    });
+
+    if (termsFound == 0) return 0;
+    return (score > 0) ? 1 : (score < 0) ? -1 : 0;
+}
+
+// Maps a scorer prediction back to the party name used in reports
+string predictionParty(int prediction) {
+    return (prediction > 0) ? "Republican" : (prediction < 0) ? "Democrat" : "Neutral";
+}
+
+// Converts the trained key term lists into scorer weights (+1 Republican, -1 Democrat)
+vector<double> keyTermWeights(const vector<string>& keyTermParty) {
+    vector<double> weights;
+    for (const string& party : keyTermParty) {
+        weights.push_back(party == "Republican" ? 1.0 : -1.0);
+    }
+    return weights;
+}
+
+// Saves a model as text, one entry per line:
+//   window <negation window>
+//   term <weight> <word> [word...]
+//   negator <word>
+bool saveAlignmentModel(string path, const vector<string>& terms, const vector<double>& weights, const vector<string>& negators,
+                        int negationWindow) {
+    ofstream fout(path);
+    if (!fout.is_open()) {
+        cerr << "Error: Could not create " << path << endl;
+        return false;
+    }
+    fout << "# alignment model v1" << "\n";
+    fout << "window " << negationWindow << "\n";
+    fout << setprecision(17);
+    for (size_t i = 0; i < terms.size(); ++i) {
+        fout << "term " << weights[i] << " " << terms[i] << "\n";
+    }
+    for (const string& w : negators) {
+        fout << "negator " << w << "\n";
+    }
+    fout.close();
+    return true;
+}
+
+// Loads a model written by saveAlignmentModel
+bool loadAlignmentModel(string path, vector<string>& terms, vector<double>& weights, vector<string>& negators, int& negationWindow) {
+    terms.clear();
+    weights.clear();
+    negators.clear();
+    ifstream fin(path);
+    if (!fin.is_open()) {
+        cerr << "Error: Could not open " << path << endl;
+        return false;
+    }
+    string line;
+    int lineNumber = 0;
+    while (getline(fin, line)) {
+        lineNumber++;
+        stringstream ss(line);
+        string kind;
+        if (!(ss >> kind) || kind[0] == '#') continue;
+        if (kind == "window") {
+            if (!(ss >> negationWindow) || negationWindow < 0 || negationWindow > MAX_NEGATION_WINDOW) {
+                cerr << "Error: " << path << ":" << lineNumber << " malformed window" << endl;
+                return false;
+            }
+        } else if (kind == "term") {
+            double weight = 0;
+            string word;
+            if (!(ss >> weight >> word)) {
+                cerr << "Error: " << path << ":" << lineNumber << " malformed term" << endl;
+                return false;
+            }
+            // Phrase terms continue with their remaining words
+            string next;
+            while (ss >> next) word += " " + next;
+            terms.push_back(word);
+            weights.push_back(weight);
+        } else if (kind == "negator") {
+            string word;
+            if (!(ss >> word)) {
+                cerr << "Error: " << path << ":" << lineNumber << " malformed negator" << endl;
+                return false;
+            }
+            negators.push_back(word);
+        } else {
+            cerr << "Error: " << path << ":" << lineNumber << " unknown entry " << kind << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Partial aggregates
+//
+// Every analysis splits into an aggregate and a report. The aggregates of a
+// corpus shard are written as text, one entry per line:
+//   tweets <count>
+//   words <positive words> <negative words> <lexicon entries, -1 if none>
+//   senator <tweets> <words> <positive> <negative> <emoji +> <emoji -> <talkative words> <name>
+//   biden <tweets> <words> <positive> <negative>
+//   term <republican> <democrat> <word>
+// and merged by summing entries of the same senator or term. Terms keep
+// first-seen order, which the key-term tie break depends on, so shards must
+// be contiguous and merged in corpus order; the merge is then associative and
+// merged partials can be written and merged again.
+// ---------------------------------------------------------------------------
+
+bool writeAnalysisPartial(string path, long long tweetCount, int positiveCount, int negativeCount, int lexiconEntries,
+                          const vector<string>& senators, const vector<int>& senTweets, const vector<int>& senWords,
+                          const vector<double>& senPositive, const vector<double>& senNegative, const vector<int>& senEmojiPositive,
+                          const vector<int>& senEmojiNegative, const vector<int>& senTalkWords, int bidenTweets, int bidenWords,
+                          double bidenPositive, double bidenNegative, const vector<string>& vocab, const vector<int>& repCounts,
+                          const vector<int>& demCounts) {
+    ofstream fout(path);
+    if (!fout.is_open()) {
+        cerr << "Error: Could not create " << path << endl;
+        return false;
+    }
+    fout << "# analysis partial v1" << "\n";
+    fout << "tweets " << tweetCount << "\n";
+    fout << "words " << positiveCount << " " << negativeCount << " " << lexiconEntries << "\n";
+    fout << setprecision(17);
+    for (size_t s = 0; s < senators.size(); ++s) {
+        fout << "senator " << senTweets[s] << " " << senWords[s] << " " << senPositive[s] << " " << senNegative[s] << " "
+             << senEmojiPositive[s] << " " << senEmojiNegative[s] << " " << senTalkWords[s] << " " << senators[s] << "\n";
+    }
+    fout << "biden " << bidenTweets << " " << bidenWords << " " << bidenPositive << " " << bidenNegative << "\n";
+    for (size_t i = 0; i < vocab.size(); ++i) {
+        fout << "term " << repCounts[i] << " " << demCounts[i] << " " << vocab[i] << "\n";
+    }
+    fout.close();
+    return true;
+}
+
+// Runs every analysis's aggregate over the loaded corpus and writes the partial
+bool emitAnalysisPartial(string path, const vector<vector<string>>& tweets, const vector<string>& senators, int positiveCount,
+                         int negativeCount, int lexiconEntries, const vector<string>& lexiconTerms, const vector<double>& lexiconScores,
+                         const vector<string>& negators, int negationWindow, const vector<unsigned long long>& sentimentStopFilter,
+                         const vector<unsigned long long>& stopFilter) {
+    vector<int> senTweets, senWords, senEmojiPositive, senEmojiNegative, talkTweets, talkWords;
+    vector<double> senPositive, senNegative;
+    aggregateSenatorSentiment(tweets, senators, lexiconTerms, lexiconScores, negators, negationWindow, sentimentStopFilter, senTweets,
+                              senWords, senPositive, senNegative, senEmojiPositive, senEmojiNegative);
+    countSenatorWords(tweets, senators, talkTweets, talkWords);
+
+    int bidenTweets = 0;
+    int bidenWords = 0;
+    double bidenPositive = 0;
+    double bidenNegative = 0;
+    aggregateBidenSentiment(tweets, lexiconTerms, lexiconScores, negators, negationWindow, sentimentStopFilter, bidenTweets, bidenWords,
+                            bidenPositive, bidenNegative);
+
+    vector<string> keyTerms, keyTermParty, vocab;
+    vector<int> repCounts, demCounts;
+    trainAlignmentModel(tweets, stopFilter, keyTerms, keyTermParty, 1, vocab, repCounts, demCounts);
+
+    return writeAnalysisPartial(path, static_cast<long long>(tweets.size()), positiveCount, negativeCount, lexiconEntries, senators,
+                                senTweets, senWords, senPositive, senNegative, senEmojiPositive, senEmojiNegative, talkWords, bidenTweets,
+                                bidenWords, bidenPositive, bidenNegative, vocab, repCounts, demCounts);
+}
+
+// Adds a partial file into the running merge. Senators and terms are indexed
+// by first-seen id through their intern tables; partials counts the files
+// merged so far, and every file must agree on the word list sizes.
+bool mergeAnalysisPartial(string path, int& partials, long long& tweetCount, int& positiveCount, int& negativeCount,
+                          int& lexiconEntries, vector<string>& senatorNames, vector<int>& senatorTable, vector<int>& senTweets,
+                          vector<int>& senWords, vector<double>& senPositive, vector<double>& senNegative, vector<int>& senEmojiPositive,
+                          vector<int>& senEmojiNegative, vector<int>& senTalkWords, int& bidenTweets, int& bidenWords,
+                          double& bidenPositive, double& bidenNegative, vector<string>& vocab, vector<int>& vocabTable,
+                          vector<int>& repCounts, vector<int>& demCounts) {
+    ifstream fin(path);
+    if (!fin.is_open()) {
+        cerr << "Error: Could not open " << path << endl;
+        return false;
+    }
+    string line;
+    int lineNumber = 0;
+    bool sawWords = false;
+    while (getline(fin, line)) {
+        lineNumber++;
+        stringstream ss(line);
+        string kind;
+        if (!(ss >> kind) || kind[0] == '#') continue;
+        bool ok = true;
+        if (kind == "tweets") {
+            long long count = 0;
+            ok = static_cast<bool>(ss >> count);
+            tweetCount += count;
+        } else if (kind == "words") {
+            int positive = 0, negative = 0, entries = 0;
+            ok = static_cast<bool>(ss >> positive >> negative >> entries);
+            if (ok && partials > 0 && (positive != positiveCount || negative != negativeCount || entries != lexiconEntries)) {
+                cerr << "Error: " << path << " was aggregated with different word lists" << endl;
+                return false;
+            }
+            positiveCount = positive;
+            negativeCount = negative;
+            lexiconEntries = entries;
+            sawWords = true;
+        } else if (kind == "senator") {
+            int tweets = 0, words = 0, emojiPositive = 0, emojiNegative = 0, talkWords = 0;
+            double positive = 0, negative = 0;
+            string name;
+            ok = static_cast<bool>(ss >> tweets >> words >> positive >> negative >> emojiPositive >> emojiNegative >> talkWords) &&
+                 static_cast<bool>(getline(ss >> ws, name)) && !name.empty();
+            if (ok) {
+                int id = internString(name, senatorNames, senatorTable);
+                if (id == static_cast<int>(senTweets.size())) {
+                    senTweets.push_back(0);
+                    senWords.push_back(0);
+                    senPositive.push_back(0.0);
+                    senNegative.push_back(0.0);
+                    senEmojiPositive.push_back(0);
+                    senEmojiNegative.push_back(0);
+                    senTalkWords.push_back(0);
+                }
+                senTweets[id] += tweets;
+                senWords[id] += words;
+                senPositive[id] += positive;
+                senNegative[id] += negative;
+                senEmojiPositive[id] += emojiPositive;
+                senEmojiNegative[id] += emojiNegative;
+                senTalkWords[id] += talkWords;
+            }
+        } else if (kind == "biden") {
+            int tweets = 0, words = 0;
+            double positive = 0, negative = 0;
+            ok = static_cast<bool>(ss >> tweets >> words >> positive >> negative);
+            bidenTweets += tweets;
+            bidenWords += words;
+            bidenPositive += positive;
+            bidenNegative += negative;
+        } else if (kind == "term") {
+            int rep = 0, dem = 0;
+            string word;
+            ok = static_cast<bool>(ss >> rep >> dem >> word);
+            if (ok) {
+                int id = internString(word, vocab, vocabTable);
+                if (id == static_cast<int>(repCounts.size())) {
+                    repCounts.push_back(0);
+                    demCounts.push_back(0);
+                }
+                repCounts[id] += rep;
+                demCounts[id] += dem;
+            }
+        } else {
+            cerr << "Error: " << path << ":" << lineNumber << " unknown entry " << kind << endl;
+            return false;
+        }
+        if (!ok) {
+            cerr << "Error: " << path << ":" << lineNumber << " malformed " << kind << endl;
+            return false;
+        }
+    }
+    if (!sawWords) {
+        cerr << "Error: " << path << " is not an analysis partial" << endl;
+        return false;
+    }
+    partials++;
+    return true;
+}
+
+// Reorders per-senator totals from first-seen ids (senatorNames order) to
+// the sorted report order in senators
+void sortSenatorTotals(vector<string>& senatorNames, vector<int>& senatorTable, const vector<string>& senators, vector<int>& senTweets,
+                       vector<int>& senWords, vector<double>& senPositive, vector<double>& senNegative, vector<int>& senEmojiPositive,
+                       vector<int>& senEmojiNegative, vector<int>& senTalkWords) {
+    vector<int> idTweets(senTweets), idWords(senWords), idEmojiPositive(senEmojiPositive), idEmojiNegative(senEmojiNegative);
+    vector<int> idTalkWords(senTalkWords);
+    vector<double> idPositive(senPositive), idNegative(senNegative);
+    for (size_t s = 0; s < senators.size(); ++s) {
+        int id = internString(senators[s], senatorNames, senatorTable);
+        senTweets[s] = idTweets[id];
+        senWords[s] = idWords[id];
+        senPositive[s] = idPositive[id];
+        senNegative[s] = idNegative[id];
+        senEmojiPositive[s] = idEmojiPositive[id];
+        senEmojiNegative[s] = idEmojiNegative[id];
+        senTalkWords[s] = idTalkWords[id];
+    }
+}
+
+// Merge mode: merges the partials in order and prints the reports of a
+// single run over their shards. Alignment accuracy needs the tweets, so only
+// the key terms are reported; counts and dates are not aggregated.
+// Returns the process exit code.
+int runPartialMerge(const vector<string>& paths, int runPlan, ReportFormat format, const string& emitPath, const string& modelPath,
+                    const vector<string>& negators, int negationWindow, ostream& out) {
+    if (runPlan & (RUN_COUNTS | RUN_DATES)) {
+        cerr << "Error: --merge cannot report counts or dates" << endl;
+        return 1;
+    }
+    bool table = (format == REPORT_TABLE);
+    if (table && emitPath.empty() && modelPath.empty()) out << "Reading data files..." << endl;
+
+    int partials = 0;
+    long long tweetCount = 0;
+    int positiveCount = 0, negativeCount = 0, lexiconEntries = -1;
+    vector<string> senatorNames, vocab;
+    vector<int> senatorTable, vocabTable;
+    vector<int> senTweets, senWords, senEmojiPositive, senEmojiNegative, senTalkWords;
+    vector<double> senPositive, senNegative;
+    int bidenTweets = 0, bidenWords = 0;
+    double bidenPositive = 0, bidenNegative = 0;
+    vector<int> repCounts, demCounts;
+    for (const string& path : paths) {
+        if (!mergeAnalysisPartial(path, partials, tweetCount, positiveCount, negativeCount, lexiconEntries, senatorNames, senatorTable,
+                                  senTweets, senWords, senPositive, senNegative, senEmojiPositive, senEmojiNegative, senTalkWords, bidenTweets,
+                                  bidenWords, bidenPositive, bidenNegative, vocab, vocabTable, repCounts, demCounts)) {
+            return 1;
+        }
+    }
+
+    vector<string> senators = sortedSenators(senatorNames);
+    sortSenatorTotals(senatorNames, senatorTable, senators, senTweets, senWords, senPositive, senNegative, senEmojiPositive,
+                      senEmojiNegative, senTalkWords);
+
+    if (!emitPath.empty()) {
+        if (!writeAnalysisPartial(emitPath, tweetCount, positiveCount, negativeCount, lexiconEntries, senators, senTweets, senWords,
+                                  senPositive, senNegative, senEmojiPositive, senEmojiNegative, senTalkWords, bidenTweets, bidenWords,
+                                  bidenPositive, bidenNegative, vocab, repCounts, demCounts)) {
+            return 1;
+        }
+        out << "Merged " << partials << " partials (" << tweetCount << " tweets) into " << emitPath << endl;
+        return 0;
+    }
+
+    vector<string> keyTerms, keyTermParty;
+    keyTermsFromCounts(vocab, repCounts, demCounts, keyTerms, keyTermParty);
+    if (!modelPath.empty()) {
+        if (!saveAlignmentModel(modelPath, keyTerms, keyTermWeights(keyTermParty), negators, negationWindow)) return 1;
+        out << "Saved " << keyTerms.size() << " terms to " << modelPath << endl;
+        return 0;
+    }
+
+    // Same layout as a single run's reports
+    ostringstream report;
+    if (table) {
+        report << "Data loaded." << '\n';
+        report << "Tweets: " << tweetCount << '\n';
+        if (runPlan & (RUN_SENTIMENT | RUN_BIDEN)) {
+            report << "Positive Words: " << positiveCount << '\n';
+            report << "Negative Words: " << negativeCount << '\n';
+        }
+        if (lexiconEntries >= 0) report << "Lexicon Entries: " << lexiconEntries << '\n';
+        report << "Senators: " << senators.size() << '\n';
+        report << '\n';
+    }
+    if (runPlan & RUN_SENTIMENT) {
+        if (table) report << "--- Part 1: Sentiment Analysis ---" << '\n';
+        reportSentiment(senators, senWords, senPositive, senNegative, senEmojiPositive, senEmojiNegative, report, format);
+        if (table) report << '\n';
+    }
+    if (table && (runPlan & (RUN_TALKATIVE | RUN_BIDEN))) report << "--- Part 2: Additional Capabilities ---" << '\n';
+    if (runPlan & RUN_TALKATIVE) {
+        if (table) report << "1. Most Talkative Senator:" << '\n';
+        reportMostTalkative(senators, senTweets, senTalkWords, report, format);
+        if (table) report << '\n';
+    }
+    if (runPlan & RUN_BIDEN) {
+        if (table) report << "2. Biden Sentiment Analysis:" << '\n';
+        reportBidenSentiment(bidenTweets, bidenWords, bidenPositive, bidenNegative, report, format);
+        if (table) report << '\n';
+    }
+    if (runPlan & RUN_ALIGNMENT) {
+        if (table) report << "--- Extra Credit: Political Alignment Analysis ---" << '\n';
+        reportKeyTerms(keyTerms, keyTermParty, report, format);
+    }
+    if (runPlan & RUN_SENATORS) reportSenatorList(senators, report, format);
+
+    const string& text = report.str();
+    out.write(text.data(), static_cast<streamsize>(text.size()));
+    out.flush();
+    return 0;
+}
+
+// Reads one text per line from in and writes one predicted party per line,
+// reporting throughput on stderr
+void runAlignmentPredictor(const vector<unsigned long long>& scorerKeys, const vector<double>& scorerWeights,
+                           const vector<unsigned char>& scorerFlags, int negationWindow, istream& in, ostream& out) {
+    ios::sync_with_stdio(false);
+    METRIC_TIMER_BEGIN(TIMER_PREDICT);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    string line;
+    string buffer;
+    long long count = 0;
+    const string labels[3] = {"Democrat\n", "Neutral\n", "Republican\n"};
+    while (getline(in, line)) {
+        buffer += labels[predictWithScorer(line, scorerKeys, scorerWeights, scorerFlags, negationWindow) + 1];
+        count++;
+        if (buffer.size() >= (1 << 16)) {
+            out << buffer;
+            buffer.clear();
+        }
+    }
+    out << buffer;
+    out.flush();
+    METRIC_ADD(COUNTER_PREDICTIONS, count);
+    METRIC_TIMER_END(TIMER_PREDICT);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cerr << "Predicted " << count << " texts in " << seconds << " s ("
+         << (seconds > 0 ? count / seconds : 0.0) << " texts/s)" << endl;
+}
+
+// Extra Credit: Political Alignment Analysis
+void analyzePoliticalAlignment(const vector<vector<string>>& tweets, const vector<string>& senators, const vector<string>& negators, int negationWindow,
+                               const vector<unsigned long long>& stopFilter, ostream& out, ReportFormat format, int maxNgram) {
+    if (format == REPORT_TABLE) out << "Building political term list from tweets..." << '\n';
+
+    vector<string> keyTerms;
+    vector<string> keyTermParty;
+    trainAlignmentModel(tweets, stopFilter, keyTerms, keyTermParty, maxNgram);
+    reportKeyTerms(keyTerms, keyTermParty, out, format);
+
+    // 3. Analyze Tweets
+    if (format == REPORT_TABLE) out << "Analyzing tweets for alignment..." << '\n';
+
+    vector<unsigned long long> scorerKeys;
+    vector<double> scorerWeights;
+    vector<unsigned char> scorerFlags;
+    buildAlignmentScorer(keyTerms, keyTermWeights(keyTermParty), negators, scorerKeys, scorerWeights, scorerFlags);
+    
+    // Per-worker accumulators; the row past the last senator counts
+    // predictions for senators outside the list, for the overall totals
+    size_t rows = senators.size() + 1;
+    int tasks = static_cast<int>((tweets.size() + POOL_TASK_ROWS - 1) / POOL_TASK_ROWS);
+    int workers = poolWorkers(tasks);
+    vector<int> tallies;
+    size_t base = initAccumulators(tallies, workers, 2, rows);
+    runStealingPool(tasks, workers, [&](int w, int t) {
+        int* correctCounts = accumulatorColumn(tallies, base, w, 0, 2, rows);
+        int* totalCounts = accumulatorColumn(tallies, base, w, 1, 2, rows);
+        size_t rowEnd = min(tweets.size(), static_cast<size_t>(t + 1) * POOL_TASK_ROWS);
+        for (size_t r = static_cast<size_t>(t) * POOL_TASK_ROWS; r < rowEnd; ++r) {
+            const vector<string>& row = tweets[r];
+            if (row.size() < 5) continue;
+            string actualParty = getParty(row[3]);
+            string predicted = predictionParty(predictWithScorer(row[4], scorerKeys, scorerWeights, scorerFlags, negationWindow));
+            if (predicted == "Neutral") continue;
+
+            // Update senator stats
+            size_t s = lower_bound(senators.begin(), senators.end(), row[3]) - senators.begin();
+            if (s >= senators.size() || senators[s] != row[3]) s = senators.size();
+            totalCounts[s]++;
+            if (predicted == actualParty) correctCounts[s]++;
+        }
+    });
+    mergeAccumulators(tallies, base, workers, 2, rows);
+
+    const int* correctCounts = accumulatorColumn(tallies, base, 0, 0, 2, rows);
+    const int* totalCounts = accumulatorColumn(tallies, base, 0, 1, 2, rows);
+    vector<int> senCorrect(correctCounts, correctCounts + senators.size());
+    vector<int> senTotal(totalCounts, totalCounts + senators.size());
+    int correctPredictions = 0;
+    int totalPredictions = 0;
+    for (size_t s = 0; s < rows; ++s) {
+        correctPredictions += correctCounts[s];
+        totalPredictions += totalCounts[s];
+    }
+
+    printAlignmentAccuracy(senators, senCorrect, senTotal, correctPredictions, totalPredictions, out, format);
+}
+
+// Prints the key terms the alignment model picked
+void reportKeyTerms(const vector<string>& keyTerms, const vector<string>& keyTermParty, ostream& out, ReportFormat format) {
+    if (format == REPORT_TABLE) {
+        out << "Identified Key Political Terms:" << '\n';
+        for(size_t i=0; i<keyTerms.size(); ++i) {
+            out << left << setw(20) << keyTerms[i] << keyTermParty[i] << '\n';
+        }
+        out << '\n';
+    } else {
+        vector<vector<string>> records;
+        for (size_t i = 0; i < keyTerms.size(); ++i) records.push_back({keyTerms[i], keyTermParty[i]});
+        writeReportSection(out, format, "alignment_terms", {"term", "party"}, "ss", records);
+    }
+}
+
+// Prints per-senator and overall alignment prediction accuracy
+void printAlignmentAccuracy(const vector<string>& senators, const vector<int>& senCorrect, const vector<int>& senTotal,
+                            int correctPredictions, int totalPredictions, ostream& out, ReportFormat format) {
+    double overall = (totalPredictions > 0 ? static_cast<double>(correctPredictions) / totalPredictions * 100.0 : 0.0);
+    if (format != REPORT_TABLE) {
+        vector<vector<string>> records;
+        for (size_t s = 0; s < senators.size(); ++s) {
+            double acc = (senTotal[s] > 0) ? static_cast<double>(senCorrect[s]) / senTotal[s] * 100.0 : 0.0;
+            records.push_back({senators[s], getParty(senators[s]), to_string(senCorrect[s]), to_string(senTotal[s]), formatReportNumber(acc, 1)});
+        }
+        records.push_back({"ALL", "", to_string(correctPredictions), to_string(totalPredictions), formatReportNumber(overall, 1)});
+        writeReportSection(out, format, "alignment", {"senator", "party", "correct", "total", "accuracy_pct"}, "ssiid", records);
+        return;
+    }
+
+    out << "Alignment Analysis Results by Senator:" << '\n';
+    out << left << setw(20) << "Senator" << setw(15) << "Party" << setw(15) << "Accuracy" << '\n';
+    out << string(50, '-') << '\n';
+
+    for(size_t s=0; s<senators.size(); ++s) {
+        double acc = (senTotal[s] > 0) ? static_cast<double>(senCorrect[s]) / senTotal[s] * 100.0 : 0.0;
+        out << left << setw(20) << senators[s] << setw(15) << getParty(senators[s]) << fixed << setprecision(1) << acc << "% (" << senCorrect[s] << "/" << senTotal[s] << ")" << '\n';
+    }
+    out << '\n';
+
+    out << "Overall Accuracy: " << overall << "%" << '\n';
+}
+
+// ---------------------------------------------------------------------------
+// Log-odds (multinomial Naive Bayes) alignment model
+//
+// Every word of the alignment vocabulary gets a weight
+//   log P(word | Republican) - log P(word | Democrat)
+// with add-alpha smoothing, and a tweet is scored as the party prior plus the
+// weights of its words. Word ids come from the same hashed vocabulary used to
+// count, and the weights live in a dense array indexed by id, so scoring is a
+// hash probe and an array read per token. Tweets with no known words fall back
+// to the prior instead of going unpredicted.
+// ---------------------------------------------------------------------------
+
+const double LOG_ODDS_ALPHA = 1.0;
+
+// Tokenizes the corpus once into shared token id arrays: the ids of tweet t's
+// vocabulary words are tokenIds[tokenOffsets[t] .. tokenOffsets[t + 1]).
+// Words are cleaned and filtered exactly as in trainAlignmentModel, and
+// tokenNegated marks the words with a negator within negationWindow tokens.
+void tokenizeForAlignment(const vector<vector<string>>& tweets, const vector<unsigned long long>& stopFilter,
+                          const vector<unsigned long long>& negHashes, int negationWindow, vector<string>& vocab,
+                          vector<int>& tokenOffsets, vector<int>& tokenIds, vector<char>& tokenNegated, vector<char>& tweetRepublican) {
+    METRIC_TIMER_BEGIN(TIMER_TOKENIZE_ALIGNMENT);
+    vector<int> vocabTable;
+    vocab.clear();
+    tokenOffsets.assign(1, 0);
+    tokenIds.clear();
+    tokenNegated.clear();
+    tweetRepublican.clear();
+
+    // Word ids of every token of the current tweet (-1 = filtered out)
+    vector<int> rowIds;
+    for (const auto& row : tweets) {
+        if (row.size() < 5) continue;
+        tweetRepublican.push_back(getParty(row[3]) == "Republican");
+        stringstream ss(row[4]);
+        string word;
+        rowIds.clear();
+        unsigned long long negMask = 0;
+        auto release = [&](int ready, bool negated) {
+            if (rowIds[ready] < 0) return;
+            tokenIds.push_back(rowIds[ready]);
+            tokenNegated.push_back(negated);
+        };
+        while (ss >> word) {
+            unsigned long long hash = termHash(word);
+            string clean = cleanWord(word);
+            bool kept = clean.length() >= 3 && !isStopWord(termHash(clean), stopFilter);
+            rowIds.push_back(kept ? internString(clean, vocab, vocabTable) : -1);
+            bool isNegator = find(negHashes.begin(), negHashes.end(), hash) != negHashes.end();
+            bool negated = advanceNegationWindow(negMask, isNegator, negationWindow);
+            int ready = static_cast<int>(rowIds.size()) - 1 - negationWindow;
+            if (ready >= 0) release(ready, negated);
+        }
+        releaseNegationTail(negMask, static_cast<int>(rowIds.size()), negationWindow, release);
+        tokenOffsets.push_back(static_cast<int>(tokenIds.size()));
+    }
+    METRIC_ADD(COUNTER_TOKENS, static_cast<long long>(tokenIds.size()));
+    METRIC_SET(COUNTER_VOCAB_SIZE, static_cast<long long>(vocab.size()));
+    METRIC_TIMER_END(TIMER_TOKENIZE_ALIGNMENT);
+}
+
+// Turns per-party count tables into smoothed log-odds weights and the prior
+void computeLogOddsWeights(const vector<long long>& repCounts, const vector<long long>& demCounts,
+                           long long repTweets, long long demTweets, vector<double>& weights, double& prior) {
+    long long repTotal = 0, demTotal = 0;
+    for (size_t i = 0; i < repCounts.size(); ++i) {
+        repTotal += repCounts[i];
+        demTotal += demCounts[i];
+    }
+    double v = static_cast<double>(repCounts.size());
+    double repDenominator = log(repTotal + LOG_ODDS_ALPHA * v);
+    double demDenominator = log(demTotal + LOG_ODDS_ALPHA * v);
+    weights.assign(repCounts.size(), 0.0);
+    for (size_t i = 0; i < repCounts.size(); ++i) {
+        weights[i] = (log(repCounts[i] + LOG_ODDS_ALPHA) - repDenominator) - (log(demCounts[i] + LOG_ODDS_ALPHA) - demDenominator);
+    }
+    prior = (repTweets > 0 && demTweets > 0) ? log(static_cast<double>(repTweets) / demTweets) : 0.0;
+}
+
+// Counts the vocabulary per party in one pass and turns the count table into
+// log-odds weights in a second pass over the table
+void trainLogOddsModel(const vector<vector<string>>& tweets, const vector<unsigned long long>& stopFilter, vector<string>& vocab,
+                       vector<double>& weights, double& prior) {
+    vector<int> tokenOffsets, tokenIds;
+    vector<char> tokenNegated, tweetRepublican;
+    // Counts are per word, negated or not; negation only flips weights when scoring
+    tokenizeForAlignment(tweets, stopFilter, {}, 0, vocab, tokenOffsets, tokenIds, tokenNegated, tweetRepublican);
+
+    vector<long long> repCounts(vocab.size(), 0);
+    vector<long long> demCounts(vocab.size(), 0);
+    long long repTweets = 0, demTweets = 0;
+    for (size_t t = 0; t < tweetRepublican.size(); ++t) {
+        vector<long long>& counts = tweetRepublican[t] ? repCounts : demCounts;
+        (tweetRepublican[t] ? repTweets : demTweets)++;
+        for (int k = tokenOffsets[t]; k < tokenOffsets[t + 1]; ++k) counts[tokenIds[k]]++;
+    }
+    computeLogOddsWeights(repCounts, demCounts, repTweets, demTweets, weights, prior);
+}
+
+// Builds the hash -> word id table used by predictLogOdds (-1 = empty slot)
+void buildVocabIndex(const vector<string>& vocab, vector<unsigned long long>& vocabKeys, vector<int>& vocabIds) {
+    size_t size = 16;
+    while (size < vocab.size() * 2) size *= 2;
+    vocabKeys.assign(size, 0);
+    vocabIds.assign(size, -1);
+    for (size_t i = 0; i < vocab.size(); ++i) {
+        unsigned long long key = termHash(vocab[i]);
+        size_t slot = key & (size - 1);
+        while (vocabIds[slot] != -1 && vocabKeys[slot] != key) slot = (slot + 1) & (size - 1);
+        vocabKeys[slot] = key;
+        vocabIds[slot] = static_cast<int>(i);
+    }
+}
+
+// Scores text as prior + sum of word weights, each flipped when a negator is
+// within negationWindow tokens of the word (the same mask stage as the
+// lexicon and scorer paths). Returns 1 (Republican) or -1 (Democrat); 0 only
+// when the score is exactly zero.
+int predictLogOdds(const string& text, const vector<unsigned long long>& vocabKeys, const vector<int>& vocabIds,
+                   const vector<double>& weights, double prior, const vector<unsigned long long>& negHashes, int negationWindow) {
+    // Word ids of the tokens not yet released (-1 = not in the vocabulary)
+    int pending[MAX_NEGATION_WINDOW + 1];
+    unsigned long long negMask = 0;
+    int ringSize = negationWindow + 1;
+    int count = 0;
+    double score = prior;
+    auto release = [&](int ready, bool negated) {
+        int id = pending[ready % ringSize];
+        if (id >= 0) score += negated ? -weights[id] : weights[id];
+    };
+
+    size_t mask = vocabKeys.size() - 1;
+    size_t pos = 0;
+    size_t n = text.size();
+    while (pos < n) {
+        while (pos < n && isTokenSpace(text[pos])) pos++;
+        if (pos >= n) break;
+        unsigned long long hash = 1469598103934665603ULL;
+        while (pos < n && !isTokenSpace(text[pos])) pos += hashTermChar(text.data() + pos, n - pos, hash);
+        unsigned long long key = (hash == 0) ? 1 : hash;
+        size_t slot = key & mask;
+        int id = -1;
+        while (vocabIds[slot] != -1) {
+            if (vocabKeys[slot] == key) {
+                id = vocabIds[slot];
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+        pending[count % ringSize] = id;
+        count++;
+
+        bool isNegator = find(negHashes.begin(), negHashes.end(), key) != negHashes.end();
+        bool negated = advanceNegationWindow(negMask, isNegator, negationWindow);
+        int ready = count - 1 - negationWindow;
+        if (ready >= 0) release(ready, negated);
+    }
+    // Release the last tokens; nothing follows them
+    releaseNegationTail(negMask, count, negationWindow, release);
+    return (score > 0) ? 1 : (score < 0) ? -1 : 0;
+}
+
+// Extra Credit (log-odds variant): trains on the tweets, prints the most
+// partisan words and the same accuracy table as analyzePoliticalAlignment
+void analyzeAlignmentLogOdds(const vector<vector<string>>& tweets, const vector<string>& senators, const vector<string>& negators,
+                             int negationWindow, const vector<unsigned long long>& stopFilter, ostream& out, ReportFormat format) {
+    if (format == REPORT_TABLE) out << "Training log-odds model over the full vocabulary..." << '\n';
+    vector<string> vocab;
+    vector<double> weights;
+    double prior = 0;
+    trainLogOddsModel(tweets, stopFilter, vocab, weights, prior);
+
+    vector<int> order(vocab.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+    sort(order.begin(), order.end(), [&](int a, int b) { return weights[a] > weights[b]; });
+
+    if (format == REPORT_TABLE) {
+        out << "Vocabulary: " << vocab.size() << " words, prior " << fixed << setprecision(3) << prior << '\n';
+        out << "Most Republican / Democrat Terms:" << '\n';
+        for (size_t k = 0; k < 15 && k < order.size(); ++k) {
+            out << left << setw(20) << vocab[order[k]] << right << setw(8) << weights[order[k]] << "    "
+                << left << setw(20) << vocab[order[order.size() - 1 - k]] << right << setw(8) << weights[order[order.size() - 1 - k]] << '\n';
+        }
+        out << '\n';
+    } else {
+        vector<vector<string>> records;
+        for (size_t k = 0; k < 15 && k < order.size(); ++k) {
+            records.push_back({vocab[order[k]], "Republican", formatReportNumber(weights[order[k]], 3)});
+        }
+        for (size_t k = 0; k < 15 && k < order.size(); ++k) {
+            size_t i = order[order.size() - 1 - k];
+            records.push_back({vocab[i], "Democrat", formatReportNumber(weights[i], 3)});
+        }
+        writeReportSection(out, format, "alignment_terms", {"term", "party", "weight"}, "ssd", records);
+    }
+
+    vector<unsigned long long> vocabKeys;
+    vector<int> vocabIds;
+    buildVocabIndex(vocab, vocabKeys, vocabIds);
+
+    vector<unsigned long long> negHashes = negatorHashes(negators);
+
+    if (format == REPORT_TABLE) out << "Analyzing tweets for alignment..." << '\n';
+    int correctPredictions = 0;
+    int totalPredictions = 0;
+    vector<int> senCorrect(senators.size(), 0);
+    vector<int> senTotal(senators.size(), 0);
+
+    for (const auto& row : tweets) {
+        if (row.size() < 5) continue;
+        string predicted = predictionParty(predictLogOdds(row[4], vocabKeys, vocabIds, weights, prior, negHashes, negationWindow));
+        if (predicted == "Neutral") continue;
+        string actualParty = getParty(row[3]);
+        totalPredictions++;
+        if (predicted == actualParty) correctPredictions++;
+
+        size_t s = lower_bound(senators.begin(), senators.end(), row[3]) - senators.begin();
+        if (s < senators.size() && senators[s] == row[3]) {
+            senTotal[s]++;
+            if (predicted == actualParty) senCorrect[s]++;
+        }
+    }
+
+    printAlignmentAccuracy(senators, senCorrect, senTotal, correctPredictions, totalPredictions, out, format);
+}
+
+// ---------------------------------------------------------------------------
+// Vocabulary sketches
+//
+// --alignment sketch trains the key-term model from fixed-size sketches
+// instead of the exact vocabulary tables, for archives whose vocabulary
+// does not fit in memory:
+//  - HyperLogLog (2^12 one-byte registers per group) estimates distinct
+//    terms overall, per party and per senator, with a standard error of
+//    1.04 / sqrt(2^12) = 1.6%.
+//  - A Count-Min sketch per party (4 rows of 2^16 counters) estimates how
+//    often a term was used. An estimate never undercounts and overcounts by
+//    at most e / 2^16 of the party's tokens with probability 1 - e^-4.
+//  - A Space-Saving summary per party (a min-heap of 512 counters with a
+//    hash index) keeps the party's heaviest terms. Any term used more than
+//    1/512 of the party's tokens is guaranteed to be among them.
+// Key terms are picked from the Space-Saving candidates by their Count-Min
+// counts, with the same rule as trainAlignmentModel. Rows are sketched in
+// shards on worker threads. The registers and the Count-Min counters are
+// shared by all workers (atomic max and relaxed atomic adds), so only the
+// small Space-Saving summaries are kept per worker and re-offered into the
+// first. Memory is 2 MB of counters, 4 KB of registers per senator plus
+// three, and 2 x 512 Space-Saving entries per worker, whatever the corpus
+// and vocabulary size.
+// ---------------------------------------------------------------------------
+
+// Spreads a term hash over all 64 bits (splitmix64 finalizer)
+inline unsigned long long sketchHash(unsigned long long hash) {
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+    return hash == 0 ? 1 : hash;
+}
+
+// Top bits pick the register, the rank of the first set bit of the rest is
+// kept. Registers only grow, so a worker raises one with compare-and-swap
+// and stops as soon as another worker has stored a rank at least as high.
+void hllAdd(vector<atomic<unsigned char>>& registers, size_t group, unsigned long long hash) {
+    size_t index = static_cast<size_t>(hash >> (64 - HLL_PRECISION));
+    unsigned long long rest = (hash << HLL_PRECISION) | (1ULL << (HLL_PRECISION - 1));
+    unsigned char rank = 1;
+    while ((rest & (1ULL << 63)) == 0) {
+        rest <<= 1;
+        rank++;
+    }
+    atomic<unsigned char>& reg = registers[group * HLL_REGISTERS + index];
+    unsigned char current = reg.load(memory_order_relaxed);
+    while (rank > current && !reg.compare_exchange_weak(current, rank, memory_order_relaxed)) {
+    }
+}
+
+// Harmonic-mean estimate, with linear counting while registers are still empty
+double hllEstimate(const vector<atomic<unsigned char>>& registers, size_t group) {
+    double m = static_cast<double>(HLL_REGISTERS);
+    double sum = 0;
+    int zeros = 0;
+    for (size_t i = 0; i < HLL_REGISTERS; ++i) {
+        unsigned char reg = registers[group * HLL_REGISTERS + i].load(memory_order_relaxed);
+        sum += ldexp(1.0, -reg);
+        if (reg == 0) zeros++;
+    }
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0) estimate = m * log(m / zeros);
+    return estimate;
+}
+
+inline size_t cmsCell(int side, int row, unsigned long long hash) {
+    return (static_cast<size_t>(side) * CMS_DEPTH + row) * CMS_WIDTH + (ngramHash(static_cast<unsigned long long>(row) + 1, hash) & (CMS_WIDTH - 1));
+}
+
+// Counters are shared by all workers; adds commute, so relaxed order is enough
+void cmsAdd(vector<atomic<unsigned int>>& cms, int side, unsigned long long hash) {
+    for (int row = 0; row < CMS_DEPTH; ++row) cms[cmsCell(side, row, hash)].fetch_add(1, memory_order_relaxed);
+}
+
+unsigned int cmsEstimate(const vector<atomic<unsigned int>>& cms, int side, unsigned long long hash) {
+    unsigned int estimate = cms[cmsCell(side, 0, hash)].load(memory_order_relaxed);
+    for (int row = 1; row < CMS_DEPTH; ++row) estimate = min(estimate, cms[cmsCell(side, row, hash)].load(memory_order_relaxed));
+    return estimate;
+}
+
+// Space-Saving: side s owns heap positions [s * capacity, s * capacity + ssSize[s])
+// and index slots [s * SPACE_SAVING_TABLE, (s + 1) * SPACE_SAVING_TABLE), each
+// holding a heap position or -1. The heap is ordered by count, smallest first.
+
+// Index slot of key: where it is, or the empty slot where it would go
+size_t spaceSavingSlot(const vector<unsigned long long>& ssKeys, const vector<int>& ssTable, int side, unsigned long long key) {
+    size_t base = static_cast<size_t>(side) * SPACE_SAVING_TABLE;
+    size_t slot = key & (SPACE_SAVING_TABLE - 1);
+    while (ssTable[base + slot] != -1 && ssKeys[ssTable[base + slot]] != key) slot = (slot + 1) & (SPACE_SAVING_TABLE - 1);
+    return base + slot;
+}
+
+// Removes key from the index, shifting later probes back into the gap
+void spaceSavingUnindex(const vector<unsigned long long>& ssKeys, vector<int>& ssTable, int side, unsigned long long key) {
+    size_t base = static_cast<size_t>(side) * SPACE_SAVING_TABLE;
+    size_t hole = spaceSavingSlot(ssKeys, ssTable, side, key) - base;
+    size_t slot = hole;
+    while (true) {
+        slot = (slot + 1) & (SPACE_SAVING_TABLE - 1);
+        if (ssTable[base + slot] == -1) break;
+        size_t home = ssKeys[ssTable[base + slot]] & (SPACE_SAVING_TABLE - 1);
+        // Move the entry back unless its home lies cyclically in (hole, slot]
+        bool stays = (hole <= slot) ? (home > hole && home <= slot) : (home > hole || home <= slot);
+        if (stays) continue;
+        ssTable[base + hole] = ssTable[base + slot];
+        hole = slot;
+    }
+    ssTable[base + hole] = -1;
+}
+
+void spaceSavingSwap(vector<unsigned long long>& ssKeys, vector<long long>& ssCounts, vector<long long>& ssErrors, vector<string>& ssTerms,
+                     vector<int>& ssTable, int side, size_t a, size_t b) {
+    size_t slotA = spaceSavingSlot(ssKeys, ssTable, side, ssKeys[a]);
+    size_t slotB = spaceSavingSlot(ssKeys, ssTable, side, ssKeys[b]);
+    swap(ssKeys[a], ssKeys[b]);
+    swap(ssCounts[a], ssCounts[b]);
+    swap(ssErrors[a], ssErrors[b]);
+    swap(ssTerms[a], ssTerms[b]);
+    ssTable[slotA] = static_cast<int>(b);
+    ssTable[slotB] = static_cast<int>(a);
+}
+
+// Restores heap order after the count at heap position pos (relative to the side) grew
+void spaceSavingSiftDown(vector<unsigned long long>& ssKeys, vector<long long>& ssCounts, vector<long long>& ssErrors, vector<string>& ssTerms,
+                         vector<int>& ssTable, const vector<int>& ssSize, int side, size_t pos) {
+    size_t base = static_cast<size_t>(side) * SPACE_SAVING_CAPACITY;
+    size_t size = ssSize[side];
+    while (true) {
+        size_t smallest = pos;
+        for (size_t child = 2 * pos + 1; child <= 2 * pos + 2 && child < size; ++child) {
+            if (ssCounts[base + child] < ssCounts[base + smallest]) smallest = child;
+        }
+        if (smallest == pos) return;
+        spaceSavingSwap(ssKeys, ssCounts, ssErrors, ssTerms, ssTable, side, base + pos, base + smallest);
+        pos = smallest;
+    }
+}
+
+// Adds count occurrences of a term to a side. A new term takes a free
+// counter, or else evicts the smallest one and inherits its count as error.
+void spaceSavingOffer(vector<unsigned long long>& ssKeys, vector<long long>& ssCounts, vector<long long>& ssErrors, vector<string>& ssTerms,
+                      vector<int>& ssTable, vector<int>& ssSize, int side, unsigned long long key, const string& term,
+                      long long count, long long error) {
+    size_t base = static_cast<size_t>(side) * SPACE_SAVING_CAPACITY;
+    size_t slot = spaceSavingSlot(ssKeys, ssTable, side, key);
+    if (ssTable[slot] != -1) {
+        size_t pos = ssTable[slot];
+        ssCounts[pos] += count;
+        ssErrors[pos] += error;
+        spaceSavingSiftDown(ssKeys, ssCounts, ssErrors, ssTerms, ssTable, ssSize, side, pos - base);
+        return;
+    }
+    if (ssSize[side] < SPACE_SAVING_CAPACITY) {
+        // Sift the new counter up from the end of the heap
+        size_t pos = ssSize[side]++;
+        ssKeys[base + pos] = key;
+        ssCounts[base + pos] = count;
+        ssErrors[base + pos] = error;
+        ssTerms[base + pos] = term;
+        ssTable[slot] = static_cast<int>(base + pos);
+        while (pos > 0 && ssCounts[base + (pos - 1) / 2] > ssCounts[base + pos]) {
+            spaceSavingSwap(ssKeys, ssCounts, ssErrors, ssTerms, ssTable, side, base + pos, base + (pos - 1) / 2);
+            pos = (pos - 1) / 2;
+        }
+        return;
+    }
+    long long floor = ssCounts[base];
+    spaceSavingUnindex(ssKeys, ssTable, side, ssKeys[base]);
+    ssKeys[base] = key;
+    ssCounts[base] = floor + count;
+    ssErrors[base] = floor + error;
+    ssTerms[base] = term;
+    ssTable[spaceSavingSlot(ssKeys, ssTable, side, key)] = static_cast<int>(base);
+    spaceSavingSiftDown(ssKeys, ssCounts, ssErrors, ssTerms, ssTable, ssSize, side, 0);
+}
+
+// Empty shared registers and counters for a corpus with senatorCount senators
+void initSharedSketches(size_t senatorCount, vector<atomic<unsigned char>>& hll, vector<atomic<unsigned int>>& cms) {
+    vector<atomic<unsigned char>> registers((HLL_FIXED_GROUPS + senatorCount) * HLL_REGISTERS);
+    vector<atomic<unsigned int>> counters(2 * CMS_DEPTH * CMS_WIDTH);
+    for (atomic<unsigned char>& reg : registers) reg.store(0, memory_order_relaxed);
+    for (atomic<unsigned int>& counter : counters) counter.store(0, memory_order_relaxed);
+    hll.swap(registers);
+    cms.swap(counters);
+}
+
+// Empty Space-Saving summaries and token totals for one worker
+void initVocabSketch(vector<unsigned long long>& ssKeys, vector<long long>& ssCounts, vector<long long>& ssErrors, vector<string>& ssTerms,
+                     vector<int>& ssTable, vector<int>& ssSize, vector<long long>& sideTokens) {
+    ssKeys.assign(2 * SPACE_SAVING_CAPACITY, 0);
+    ssCounts.assign(2 * SPACE_SAVING_CAPACITY, 0);
+    ssErrors.assign(2 * SPACE_SAVING_CAPACITY, 0);
+    ssTerms.assign(2 * SPACE_SAVING_CAPACITY, "");
+    ssTable.assign(2 * SPACE_SAVING_TABLE, -1);
+    ssSize.assign(2, 0);
+    sideTokens.assign(2, 0);
+}
+
+// Sketches the kept words (as trainAlignmentModel keeps them) of rows
+// [rowBegin, rowEnd). Side 0 is Republican, side 1 Democrat.
+void buildVocabSketch(const vector<vector<string>>& tweets, size_t rowBegin, size_t rowEnd, const vector<string>& senators,
+                      const vector<unsigned long long>& stopFilter, vector<atomic<unsigned char>>& hll, vector<atomic<unsigned int>>& cms,
+                      vector<unsigned long long>& ssKeys, vector<long long>& ssCounts, vector<long long>& ssErrors, vector<string>& ssTerms,
+                      vector<int>& ssTable, vector<int>& ssSize, vector<long long>& sideTokens) {
+    for (size_t r = rowBegin; r < rowEnd; ++r) {
+        const vector<string>& row = tweets[r];
+        if (row.size() < 5) continue;
+        int side = (getParty(row[3]) == "Republican") ? 0 : 1;
+        size_t senator = lower_bound(senators.begin(), senators.end(), row[3]) - senators.begin();
+        stringstream ss(row[4]);
+        string word;
+        while (ss >> word) {
+            string clean = cleanWord(word);
+            if (clean.length() < 3) continue;
+            unsigned long long hash = termHash(clean);
+            if (isStopWord(hash, stopFilter)) continue;
+            unsigned long long key = sketchHash(hash);
+            hllAdd(hll, 0, key);
+            hllAdd(hll, 1 + side, key);
+            if (senator < senators.size()) hllAdd(hll, HLL_FIXED_GROUPS + senator, key);
+            cmsAdd(cms, side, key);
+            spaceSavingOffer(ssKeys, ssCounts, ssErrors, ssTerms, ssTable, ssSize, side, key, clean, 1, 0);
+            sideTokens[side]++;
+        }
+    }
+}
+
+// Merges a worker's Space-Saving summaries and token totals into the first set
+void mergeVocabSketch(vector<unsigned long long>& ssKeys, vector<long long>& ssCounts, vector<long long>& ssErrors, vector<string>& ssTerms,
+                      vector<int>& ssTable, vector<int>& ssSize, vector<long long>& sideTokens,
+                      const vector<unsigned long long>& srcKeys, const vector<long long>& srcCounts, const vector<long long>& srcErrors,
+                      const vector<string>& srcTerms, const vector<int>& srcSize, const vector<long long>& srcSideTokens) {
+    for (int side = 0; side < 2; ++side) {
+        size_t base = static_cast<size_t>(side) * SPACE_SAVING_CAPACITY;
+        for (int k = 0; k < srcSize[side]; ++k) {
+            spaceSavingOffer(ssKeys, ssCounts, ssErrors, ssTerms, ssTable, ssSize, side, srcKeys[base + k], srcTerms[base + k],
+                             srcCounts[base + k], srcErrors[base + k]);
+        }
+        sideTokens[side] += srcSideTokens[side];
+    }
+}
+
+// Extra Credit (sketch variant): sketches the vocabulary on worker threads,
+// reports distinct-term estimates and the key terms with their error bounds,
+// then scores the tweets like analyzePoliticalAlignment
+void analyzeAlignmentSketch(const vector<vector<string>>& tweets, const vector<string>& senators, const vector<string>& negators,
+                            int negationWindow, const vector<unsigned long long>& stopFilter, ostream& out, ReportFormat format) {
+    if (format == REPORT_TABLE) out << "Sketching the vocabulary (HyperLogLog, Count-Min, Space-Saving)..." << '\n';
+    METRIC_TIMER_BEGIN(TIMER_ALIGNMENT_TRAIN);
+
+    // 1. Shared registers and counters; one Space-Saving summary per worker
+    //    over a contiguous shard of rows, merged into the first
+    int workers = static_cast<int>(thread::hardware_concurrency());
+    if (workers < 1) workers = 1;
+    size_t shardRows = (tweets.size() + workers - 1) / workers;
+    vector<atomic<unsigned char>> hll;
+    vector<atomic<unsigned int>> cms;
+    initSharedSketches(senators.size(), hll, cms);
+    vector<vector<unsigned long long>> ssKeys(workers);
+    vector<vector<long long>> ssCounts(workers), ssErrors(workers), sideTokens(workers);
+    vector<vector<string>> ssTerms(workers);
+    vector<vector<int>> ssTable(workers), ssSize(workers);
+    vector<thread> pool;
+    for (int w = 0; w < workers; ++w) {
+        initVocabSketch(ssKeys[w], ssCounts[w], ssErrors[w], ssTerms[w], ssTable[w], ssSize[w], sideTokens[w]);
+        size_t rowBegin = min(tweets.size(), w * shardRows);
+        size_t rowEnd = min(tweets.size(), rowBegin + shardRows);
+        pool.push_back(thread([&, w, rowBegin, rowEnd]() {
+            buildVocabSketch(tweets, rowBegin, rowEnd, senators, stopFilter, hll, cms, ssKeys[w], ssCounts[w], ssErrors[w],
+                             ssTerms[w], ssTable[w], ssSize[w], sideTokens[w]);
+        }));
+    }
+    for (thread& worker : pool) worker.join();
+    for (int w = 1; w < workers; ++w) {
+        mergeVocabSketch(ssKeys[0], ssCounts[0], ssErrors[0], ssTerms[0], ssTable[0], ssSize[0], sideTokens[0],
+                         ssKeys[w], ssCounts[w], ssErrors[w], ssTerms[w], ssSize[w], sideTokens[w]);
+    }
+
+    // 2. Candidates: both parties' heavy hitters, scored by their Count-Min counts
+    vector<string> candTerms;
+    vector<unsigned int> candRep, candDem;
+    for (int side = 0; side < 2; ++side) {
+        for (int k = 0; k < ssSize[0][side]; ++k) {
+            size_t pos = static_cast<size_t>(side) * SPACE_SAVING_CAPACITY + k;
+            if (side == 1 && ssTable[0][spaceSavingSlot(ssKeys[0], ssTable[0], 0, ssKeys[0][pos])] != -1) continue;
+            candTerms.push_back(ssTerms[0][pos]);
+            candRep.push_back(cmsEstimate(cms, 0, ssKeys[0][pos]));
+            candDem.push_back(cmsEstimate(cms, 1, ssKeys[0][pos]));
+        }
+    }
+    vector<string> keyTerms, keyTermParty;
+    vector<unsigned int> keyRep, keyDem;
+    vector<char> picked(candTerms.size(), 0);
+    for (int side = 0; side < 2; ++side) {
+        for (int k = 0; k < 15; ++k) {
+            long long maxDiff = -1;
+            int bestIdx = -1;
+            for (size_t i = 0; i < candTerms.size(); ++i) {
+                long long diff = (side == 0) ? static_cast<long long>(candRep[i]) - candDem[i] : static_cast<long long>(candDem[i]) - candRep[i];
+                if (!picked[i] && diff > maxDiff && (candRep[i] + candDem[i] > 5)) {
+                    maxDiff = diff;
+                    bestIdx = static_cast<int>(i);
+                }
+            }
+            if (bestIdx == -1) continue;
+            picked[bestIdx] = 1;
+            keyTerms.push_back(candTerms[bestIdx]);
+            keyTermParty.push_back(side == 0 ? "Republican" : "Democrat");
+            keyRep.push_back(candRep[bestIdx]);
+            keyDem.push_back(candDem[bestIdx]);
+        }
+    }
+    METRIC_TIMER_END(TIMER_ALIGNMENT_TRAIN);
+
+    // 3. Report the estimates and their error bounds
+    double hllError = 104.0 / sqrt(static_cast<double>(HLL_REGISTERS));
+    double cmsEpsilon = exp(1.0) / CMS_WIDTH;
+    long long repBound = static_cast<long long>(ceil(cmsEpsilon * sideTokens[0][0]));
+    long long demBound = static_cast<long long>(ceil(cmsEpsilon * sideTokens[0][1]));
+    vector<string> groups = {"ALL", "Republican", "Democrat"};
+    groups.insert(groups.end(), senators.begin(), senators.end());
+    if (format == REPORT_TABLE) {
+        out << "Distinct terms (HyperLogLog, +/-" << fixed << setprecision(1) << hllError << "% standard error):" << '\n';
+        for (size_t g = 0; g < groups.size(); ++g) {
+            out << left << setw(20) << groups[g] << right << setw(10) << fixed << setprecision(0) << hllEstimate(hll, g) << '\n';
+        }
+        out << '\n';
+        out << "Identified Key Political Terms (Count-Min counts overestimate by at most " << repBound << " Republican / "
+            << demBound << " Democrat uses with " << fixed << setprecision(1) << (1 - exp(-CMS_DEPTH)) * 100.0 << "% confidence):" << '\n';
+        for (size_t i = 0; i < keyTerms.size(); ++i) {
+            out << left << setw(20) << keyTerms[i] << setw(12) << keyTermParty[i] << right << setw(8) << keyRep[i] << setw(8) << keyDem[i] << '\n';
+        }
+        out << '\n';
+        out << "Analyzing tweets for alignment..." << '\n';
+    } else {
+        vector<vector<string>> records;
+        for (size_t g = 0; g < groups.size(); ++g) {
+            records.push_back({groups[g], formatReportNumber(hllEstimate(hll, g), 0), formatReportNumber(hllError, 2)});
+        }
+        writeReportSection(out, format, "sketch_distinct", {"group", "distinct_terms", "std_error_pct"}, "sdd", records);
+        records.clear();
+        for (size_t i = 0; i < keyTerms.size(); ++i) {
+            records.push_back({keyTerms[i], keyTermParty[i], to_string(keyRep[i]), to_string(keyDem[i]), to_string(repBound), to_string(demBound)});
+        }
+        writeReportSection(out, format, "alignment_terms", {"term", "party", "republican", "democrat", "republican_bound", "democrat_bound"},
+                           "ssiiii", records);
+    }
+
+    // 4. Score the tweets with the sketched key terms
+    vector<unsigned long long> scorerKeys;
+    vector<double> scorerWeights;
+    vector<unsigned char> scorerFlags;
+    buildAlignmentScorer(keyTerms, keyTermWeights(keyTermParty), negators, scorerKeys, scorerWeights, scorerFlags);
+    int correctPredictions = 0;
+    int totalPredictions = 0;
+    vector<int> senCorrect(senators.size(), 0);
+    vector<int> senTotal(senators.size(), 0);
+    for (const auto& row : tweets) {
+        if (row.size() < 5) continue;
+        string predicted = predictionParty(predictWithScorer(row[4], scorerKeys, scorerWeights, scorerFlags, negationWindow));
+        if (predicted == "Neutral") continue;
+        string actualParty = getParty(row[3]);
+        totalPredictions++;
+        if (predicted == actualParty) correctPredictions++;
+
+        size_t s = lower_bound(senators.begin(), senators.end(), row[3]) - senators.begin();
+        if (s < senators.size() && senators[s] == row[3]) {
+            senTotal[s]++;
+            if (predicted == actualParty) senCorrect[s]++;
+        }
+    }
+
+    printAlignmentAccuracy(senators, senCorrect, senTotal, correctPredictions, totalPredictions, out, format);
+}
+
+// ---------------------------------------------------------------------------
+// Cross-validated alignment evaluation
+//
+// Scores the log-odds model on tweets it was not trained on. Tweets are
+// partitioned into k shuffled folds (or one fold per senator for
+// leave-one-senator-out); each fold trains on the other folds and is scored
+// on its own tweets. The corpus is tokenized once into shared read-only token
+// id arrays and the folds run in parallel, each with private count tables.
+// ---------------------------------------------------------------------------
+
+const unsigned int CV_SHUFFLE_SEED = 20251209;
+
+// Trains on every tweet outside the fold and scores the tweets inside it
+void evaluateLogOddsFold(int fold, const vector<int>& foldOf, const vector<int>& tokenOffsets, const vector<int>& tokenIds,
+                         const vector<char>& tokenNegated, size_t vocabSize, const vector<char>& tweetRepublican, int& correct, int& total) {
+    vector<long long> repCounts(vocabSize, 0);
+    vector<long long> demCounts(vocabSize, 0);
+    long long repTweets = 0, demTweets = 0;
+    for (size_t t = 0; t < foldOf.size(); ++t) {
+        if (foldOf[t] == fold) continue;
+        vector<long long>& counts = tweetRepublican[t] ? repCounts : demCounts;
+        (tweetRepublican[t] ? repTweets : demTweets)++;
+        for (int k = tokenOffsets[t]; k < tokenOffsets[t + 1]; ++k) counts[tokenIds[k]]++;
+    }
+
+    vector<double> weights;
+    double prior = 0;
+    computeLogOddsWeights(repCounts, demCounts, repTweets, demTweets, weights, prior);
+
+    correct = 0;
+    total = 0;
+    for (size_t t = 0; t < foldOf.size(); ++t) {
+        if (foldOf[t] != fold) continue;
+        double score = prior;
+        for (int k = tokenOffsets[t]; k < tokenOffsets[t + 1]; ++k) score += tokenNegated[k] ? -weights[tokenIds[k]] : weights[tokenIds[k]];
+        if (score == 0) continue;
+        total++;
+        if ((score > 0) == static_cast<bool>(tweetRepublican[t])) correct++;
+    }
+}
+
+// Runs k-fold (folds > 1) or leave-one-senator-out (folds == 0) evaluation
+// and prints per-fold accuracy with the mean and variance across folds
+void crossValidateAlignment(const vector<vector<string>>& tweets, const vector<string>& senators, const vector<string>& negators,
+                            int negationWindow, const vector<unsigned long long>& stopFilter, int folds) {
+    vector<string> vocab;
+    vector<int> tokenOffsets, tokenIds;
+    vector<char> tokenNegated, tweetRepublican;
+    tokenizeForAlignment(tweets, stopFilter, negatorHashes(negators), negationWindow, vocab, tokenOffsets, tokenIds, tokenNegated,
+                         tweetRepublican);
+    size_t tweetCount = tweetRepublican.size();
+
+    // 1. Assign tweets to folds
+    vector<int> foldOf(tweetCount, 0);
+    vector<string> foldNames;
+    if (folds == 0) {
+        size_t t = 0;
+        for (const auto& row : tweets) {
+            if (row.size() < 5) continue;
+            foldOf[t++] = static_cast<int>(lower_bound(senators.begin(), senators.end(), row[3]) - senators.begin());
+        }
+        foldNames = senators;
+    } else {
+        // Deterministic Fisher-Yates shuffle so runs are reproducible
+        vector<int> order(tweetCount);
+        for (size_t i = 0; i < tweetCount; ++i) order[i] = static_cast<int>(i);
+        unsigned int state = CV_SHUFFLE_SEED;
+        for (size_t i = tweetCount; i > 1; --i) {
+            state = state * 1664525U + 1013904223U;
+            swap(order[i - 1], order[state % i]);
+        }
+        for (size_t i = 0; i < tweetCount; ++i) foldOf[order[i]] = static_cast<int>(i % folds);
+        for (int f = 0; f < folds; ++f) foldNames.push_back("Fold " + to_string(f + 1));
+    }
+    int foldCount = static_cast<int>(foldNames.size());
+
+    // 2. Evaluate the folds on a pool of worker threads
+    vector<int> foldCorrect(foldCount, 0);
+    vector<int> foldTotal(foldCount, 0);
+    atomic<int> nextFold(0);
+    int workers = static_cast<int>(thread::hardware_concurrency());
+    if (workers < 1) workers = 1;
+    if (workers > foldCount) workers = foldCount;
+    vector<thread> pool;
+    for (int w = 0; w < workers; ++w) {
+        pool.push_back(thread([&]() {
+            for (int f = nextFold++; f < foldCount; f = nextFold++) {
+                evaluateLogOddsFold(f, foldOf, tokenOffsets, tokenIds, tokenNegated, vocab.size(), tweetRepublican, foldCorrect[f],
+                                    foldTotal[f]);
+            }
+        }));
+    }
+    for (thread& worker : pool) worker.join();
+
+    // 3. Report
+    cout << (folds == 0 ? "Leave-one-senator-out" : to_string(folds) + "-fold") << " cross-validation of the log-odds model"
+         << " (" << workers << " threads)" << endl;
+    cout << left << setw(20) << "Fold" << setw(15) << "Accuracy" << endl;
+    cout << string(50, '-') << endl;
+    double sum = 0;
+    double sumSquares = 0;
+    int scored = 0;
+    for (int f = 0; f < foldCount; ++f) {
+        if (foldTotal[f] == 0) continue;
+        double acc = static_cast<double>(foldCorrect[f]) / foldTotal[f] * 100.0;
+        sum += acc;
+        sumSquares += acc * acc;
+        scored++;
+        cout << left << setw(20) << foldNames[f] << fixed << setprecision(1) << acc << "% (" << foldCorrect[f] << "/" << foldTotal[f] << ")" << endl;
+    }
+    cout << endl;
+    double mean = (scored > 0) ? sum / scored : 0.0;
+    double variance = (scored > 1) ? (sumSquares - scored * mean * mean) / (scored - 1) : 0.0;
+    if (variance < 0) variance = 0;
+    cout << "Mean Accuracy: " << fixed << setprecision(1) << mean << "%" << endl;
+    cout << "Variance: " << setprecision(2) << variance << " (std dev " << sqrt(variance) << ")" << endl;
+}
+
+// ---------------------------------------------------------------------------
+// Binary corpus format
+//
+// A converted corpus is a single file holding the tweet columns back to back so
+// a later run can load it with one read and no delimiter scanning:
+//
+//   header   magic "TWBC", version, flags (reserved, 0), row count, section table, checksum
+//   section  ids          int64 per row
+//   section  user ids     int64 per row
+//   section  timestamps   int64 epoch milliseconds per row
+//   section  senator ids  uint32 per row (index into the senator dictionary)
+//   section  senators     string table of senator names
+//   section  text offsets uint64 per row + 1 (into the text blob)
+//   section  text blob    tweet texts concatenated
+//
+// All integers are little-endian. Every section carries an FNV-1a checksum in
+// the section table and the header carries one over itself. Version 2 dropped
+// the pre-tokenized columns; files of other versions are rejected and have to
+// be converted again.
+// ---------------------------------------------------------------------------
+
+const unsigned int BINARY_CORPUS_VERSION = 2;
+const int BINARY_SECTIONS = 7;
+
+// Appends an unsigned integer to a byte buffer in little-endian order
+void appendU32(string& buf, unsigned int value) {
+    for (int i = 0; i < 4; ++i) {
+        buf.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void appendU64(string& buf, unsigned long long value) {
+    for (int i = 0; i < 8; ++i) {
+        buf.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+// Reads a little-endian unsigned integer from a byte buffer
+unsigned int readU32(const string& buf, size_t pos) {
+    unsigned int value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<unsigned int>(static_cast<unsigned char>(buf[pos + i])) << (8 * i);
+    }
+    return value;
+}
+
+unsigned long long readU64(const string& buf, size_t pos) {
+    unsigned long long value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= static_cast<unsigned long long>(static_cast<unsigned char>(buf[pos + i])) << (8 * i);
+    }
+    return value;
+}
+
+// FNV-1a hash of buf[begin, end), used for checksums and hash tables
+unsigned long long fnv1aHash(const string& buf, size_t begin, size_t end) {
+    unsigned long long hash = 1469598103934665603ULL;
+    for (size_t i = begin; i < end; ++i) {
+        hash ^= static_cast<unsigned char>(buf[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Returns the index of str in strings, appending it if it is new.
+// table is an open-addressing hash table of indexes into strings (-1 = empty)
+// that is grown whenever it becomes half full.
+int internString(const string& str, vector<string>& strings, vector<int>& table) {
+    if (table.empty() || strings.size() * 2 >= table.size()) {
+        size_t newSize = table.empty() ? 64 : table.size() * 2;
+        table.assign(newSize, -1);
+        for (size_t i = 0; i < strings.size(); ++i) {
+            size_t slot = fnv1aHash(strings[i], 0, strings[i].size()) & (newSize - 1);
+            while (table[slot] != -1) slot = (slot + 1) & (newSize - 1);
+            table[slot] = static_cast<int>(i);
+        }
+    }
+
+    size_t mask = table.size() - 1;
+    size_t slot = fnv1aHash(str, 0, str.size()) & mask;
+    while (table[slot] != -1) {
+        if (strings[table[slot]] == str) return table[slot];
+        slot = (slot + 1) & mask;
+    }
+    table[slot] = static_cast<int>(strings.size());
+    strings.push_back(str);
+    return table[slot];
+}
+
+// Days since 1970-01-01 for a civil date (proleptic Gregorian calendar)
+long long daysFromCivil(long long y, long long m, long long d) {
+    y -= (m <= 2) ? 1 : 0;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    long long yoe = y - era * 400;
+    long long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// Parses "YYYY-MM-DDTHH:MM:SS.mmmZ" into epoch milliseconds (-1 if malformed)
+long long parseIsoTimestamp(const string& iso) {
+    if (iso.size() != 24 || iso[4] != '-' || iso[7] != '-' || iso[10] != 'T' ||
+        iso[13] != ':' || iso[16] != ':' || iso[19] != '.' || iso[23] != 'Z') {
+        return -1;
+    }
+    const int digitPos[] = {0, 1, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, 17, 18, 20, 21, 22};
+    for (int p : digitPos) {
+        if (iso[p] < '0' || iso[p] > '9') return -1;
+    }
+    long long year = stoll(iso.substr(0, 4));
+    long long month = stoll(iso.substr(5, 2));
+    long long day = stoll(iso.substr(8, 2));
+    long long hour = stoll(iso.substr(11, 2));
+    long long minute = stoll(iso.substr(14, 2));
+    long long second = stoll(iso.substr(17, 2));
+    long long millis = stoll(iso.substr(20, 3));
+    long long days = daysFromCivil(year, month, day);
+    return ((days * 24 + hour) * 60 + minute) * 60000 + second * 1000 + millis;
+}
+
+// Formats epoch milliseconds back into the "YYYY-MM-DDTHH:MM:SS.mmmZ" form,
+// writing the 24 characters to out
+void formatIsoTimestamp(long long epochMillis, char* out) {
+    long long days = epochMillis / 86400000;
+    long long rem = epochMillis % 86400000;
+    if (rem < 0) {
+        rem += 86400000;
+        days--;
+    }
+
+    // Inverse of daysFromCivil
+    long long z = days + 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    long long doe = z - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    long long day = doy - (153 * mp + 2) / 5 + 1;
+    long long month = mp + (mp < 10 ? 3 : -9);
+    long long year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+    // Each field zero-padded to its width, then the separator that follows it
+    const long long fields[] = {year, month, day, rem / 3600000, (rem / 60000) % 60, (rem / 1000) % 60, rem % 1000};
+    const int digits[] = {4, 2, 2, 2, 2, 2, 3};
+    const char separators[] = {'-', '-', 'T', ':', ':', '.', 'Z'};
+    int pos = 0;
+    for (int f = 0; f < 7; ++f) {
+        long long value = fields[f];
+        for (int d = digits[f] - 1; d >= 0; --d) {
+            out[pos + d] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+        pos += digits[f];
+        out[pos++] = separators[f];
+    }
+}
+
+string formatIsoTimestamp(long long epochMillis) {
+    char buf[24];
+    formatIsoTimestamp(epochMillis, buf);
+    return string(buf, 24);
+}
+
+// Parses a decimal int64 column value, requiring it to round-trip exactly
+bool parseInt64Column(const string& field, long long& value) {
+    if (field.empty() || field.size() > 19) return false;
+    for (char c : field) {
+        if (c < '0' || c > '9') return false;
+    }
+    value = stoll(field);
+    return to_string(value) == field;
+}
+
+// Appends a string table: count, count + 1 offsets, then the bytes
+void appendStringTable(string& buf, const vector<string>& strings) {
+    appendU32(buf, static_cast<unsigned int>(strings.size()));
+    unsigned long long offset = 0;
+    for (const string& str : strings) {
+        appendU64(buf, offset);
+        offset += str.size();
+    }
+    appendU64(buf, offset);
+    for (const string& str : strings) {
+        buf += str;
+    }
+}
+
+// Reads a string table written by appendStringTable starting at pos
+bool readStringTable(const string& buf, size_t pos, size_t len, vector<string>& strings) {
+    strings.clear();
+    if (len < 4) return false;
+    size_t count = readU32(buf, pos);
+    size_t blob = pos + 4 + (count + 1) * 8;
+    if (blob > pos + len) return false;
+    for (size_t i = 0; i < count; ++i) {
+        unsigned long long begin = readU64(buf, pos + 4 + i * 8);
+        unsigned long long end = readU64(buf, pos + 4 + (i + 1) * 8);
+        if (begin > end || end > pos + len - blob) return false;
+        strings.push_back(buf.substr(blob + begin, end - begin));
+    }
+    return true;
+}
+
+// Writes the tweets into the binary corpus format described above
+bool writeBinaryCorpus(const vector<vector<string>>& tweets, string path) {
+    vector<string> sections(BINARY_SECTIONS);
+    vector<string> senatorNames;
+    vector<int> senatorTable;
+    string textBlob;
+
+    appendU64(sections[5], 0);
+
+    for (size_t r = 0; r < tweets.size(); ++r) {
+        const vector<string>& row = tweets[r];
+        long long id = 0;
+        long long userId = 0;
+        long long timestamp = parseIsoTimestamp(row[2]);
+        if (!parseInt64Column(row[0], id) || !parseInt64Column(row[1], userId) ||
+            timestamp < 0 || formatIsoTimestamp(timestamp) != row[2]) {
+            cerr << "Error: Row " << r << " has an id or timestamp that cannot be stored in binary form" << endl;
+            return false;
+        }
+        appendU64(sections[0], static_cast<unsigned long long>(id));
+        appendU64(sections[1], static_cast<unsigned long long>(userId));
+        appendU64(sections[2], static_cast<unsigned long long>(timestamp));
+        appendU32(sections[3], static_cast<unsigned int>(internString(row[3], senatorNames, senatorTable)));
+
+        textBlob += row[4];
+        appendU64(sections[5], textBlob.size());
+    }
+    appendStringTable(sections[4], senatorNames);
+    sections[6] = textBlob;
+
+    // Header: magic, version, flags, row count, section count, section table, header checksum
+    string header = "TWBC";
+    appendU32(header, BINARY_CORPUS_VERSION);
+    appendU32(header, 0);
+    appendU64(header, tweets.size());
+    appendU32(header, static_cast<unsigned int>(sections.size()));
+    unsigned long long offset = 24 + sections.size() * 24 + 8;
+    for (const string& section : sections) {
+        appendU64(header, offset);
+        appendU64(header, section.size());
+        appendU64(header, fnv1aHash(section, 0, section.size()));
+        offset += section.size();
+    }
+    appendU64(header, fnv1aHash(header, 0, header.size()));
+
+    ofstream fout(path, ios::out | ios::binary);
+    if (!fout.is_open()) {
+        cerr << "Error: Could not create " << path << endl;
+        return false;
+    }
+    fout.write(header.data(), header.size());
+    for (const string& section : sections) {
+        fout.write(section.data(), section.size());
+    }
+    fout.close();
+    return true;
+}
+
+// Loads a binary corpus with a single read. Rows are rebuilt from the column
+// sections without scanning for delimiters; columns outside the projection
+// are left empty, as in read_tweets_csv_file. Senators are interned once per
+// entry of the file's senator dictionary, not once per row.
+vector<vector<string>> readBinaryCorpus(string path, int columns, vector<string>& senatorNames, vector<int>& senatorTable) {
+    vector<vector<string>> tweets;
+
+    ifstream fin(path, ios::in | ios::binary);
+    if (!fin.is_open()) {
+        cerr << "Error: Could not open " << path << endl;
+        return tweets;
+    }
+    fin.seekg(0, ios::end);
+    size_t fileSize = static_cast<size_t>(fin.tellg());
+    fin.seekg(0, ios::beg);
+    string buf(fileSize, '\0');
+    fin.read(&buf[0], fileSize);
+    fin.close();
+
+    // 1. Validate the header
+    if (fileSize < 32 || buf.compare(0, 4, "TWBC") != 0) {
+        cerr << "Error: " << path << " is not a binary tweet corpus" << endl;
+        return tweets;
+    }
+    if (readU32(buf, 4) != BINARY_CORPUS_VERSION) {
+        cerr << "Error: " << path << " has unsupported version " << readU32(buf, 4) << endl;
+        return tweets;
+    }
+    size_t rowCount = readU64(buf, 12);
+    size_t sectionCount = readU32(buf, 20);
+    size_t headerSize = 24 + sectionCount * 24;
+    if (readU32(buf, 8) != 0 || sectionCount != BINARY_SECTIONS || fileSize < headerSize + 8 ||
+        readU64(buf, headerSize) != fnv1aHash(buf, 0, headerSize)) {
+        cerr << "Error: " << path << " has a corrupt header" << endl;
+        return tweets;
+    }
+
+    // 2. Validate the sections that are read against their checksums; the
+    //    text blob, which is most of the file, is skipped when unused
+    const int sectionColumn[] = {COL_ID, COL_USER, COL_CREATED, COL_ALL, COL_ALL, COL_ALL, COL_TEXT};
+    vector<size_t> secPos(sectionCount);
+    vector<size_t> secLen(sectionCount);
+    for (size_t i = 0; i < sectionCount; ++i) {
+        secPos[i] = readU64(buf, 24 + i * 24);
+        secLen[i] = readU64(buf, 24 + i * 24 + 8);
+        bool used = (columns & sectionColumn[i]) != 0;
+        if (secPos[i] > fileSize || secLen[i] > fileSize - secPos[i] ||
+            (used && fnv1aHash(buf, secPos[i], secPos[i] + secLen[i]) != readU64(buf, 24 + i * 24 + 16))) {
+            cerr << "Error: " << path << " failed checksum for section " << i << endl;
+            return tweets;
+        }
+    }
+    if (secLen[0] != rowCount * 8 || secLen[1] != rowCount * 8 || secLen[2] != rowCount * 8 ||
+        secLen[3] != rowCount * 4 || secLen[5] != (rowCount + 1) * 8) {
+        cerr << "Error: " << path << " has inconsistent column sizes" << endl;
+        return tweets;
+    }
+
+    vector<string> fileSenators;
+    if (!readStringTable(buf, secPos[4], secLen[4], fileSenators)) {
+        cerr << "Error: " << path << " has a corrupt senator table" << endl;
+        return tweets;
+    }
+
+    // 3. Rebuild rows from the columns, in file order so senators are
+    //    interned in the order they first appear, as when the CSV is parsed
+    vector<int> senatorIds(fileSenators.size(), -1);
+    tweets.resize(rowCount);
+    for (size_t r = 0; r < rowCount; ++r) {
+        unsigned int senatorId = readU32(buf, secPos[3] + r * 4);
+        unsigned long long textBegin = readU64(buf, secPos[5] + r * 8);
+        unsigned long long textEnd = readU64(buf, secPos[5] + (r + 1) * 8);
+        if (senatorId >= fileSenators.size() || textBegin > textEnd || textEnd > secLen[6]) {
+            cerr << "Error: " << path << " has a corrupt row " << r << endl;
+            tweets.clear();
+            return tweets;
+        }
+        vector<string>& row = tweets[r];
+        row.resize(5);
+        if (columns & COL_ID) row[0] = to_string(static_cast<long long>(readU64(buf, secPos[0] + r * 8)));
+        if (columns & COL_USER) row[1] = to_string(static_cast<long long>(readU64(buf, secPos[1] + r * 8)));
+        if (columns & COL_CREATED) {
+            row[2].resize(24);
+            formatIsoTimestamp(static_cast<long long>(readU64(buf, secPos[2] + r * 8)), &row[2][0]);
+        }
+        if (columns & COL_SENATOR) {
+            if (senatorIds[senatorId] < 0) senatorIds[senatorId] = internString(fileSenators[senatorId], senatorNames, senatorTable);
+            row[3] = senatorNames[senatorIds[senatorId]];
+        }
+        if (columns & COL_TEXT) row[4].assign(buf, secPos[6] + textBegin, textEnd - textBegin);
+    }
+
+    return tweets;
+}
+
+// ---------------------------------------------------------------------------
+// Block-compressed corpus storage
+//
+// Rows are grouped into blocks of a fixed number of rows. Each block is
+// encoded compactly (varint ids, timestamps as deltas from the block minimum,
+// senator dictionary ids, length-prefixed text) and then compressed with a
+// small LZ77 codec. The block directory records, per block, its file offset,
+// sizes, time range and the senator ids it contains, so a reader can seek to
+// and decompress only the blocks a query touches.
+//
+//   header    magic "TWBZ", version, rows per block, row count, block count
+//   senators  string table of senator names
+//   directory per block: offset, compressed size, raw size, rows, min/max
+//             timestamp, checksum, senator id count + ids
+//   checksum  FNV-1a over everything above
+//   blocks    compressed block payloads
+// ---------------------------------------------------------------------------
+
+const unsigned int COMPRESSED_CORPUS_VERSION = 1;
+const int LZ_MIN_MATCH = 4;
+const int LZ_HASH_BITS = 14;
+const size_t LZ_MAX_OFFSET = 65535;
+
+// Appends an unsigned LEB128 varint
+void appendVarint(string& buf, unsigned long long value) {
+    while (value >= 0x80) {
+        buf.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buf.push_back(static_cast<char>(value));
+}
+
+// Reads a varint at pos and advances pos; returns false on truncated input
+bool readVarint(const string& buf, size_t& pos, unsigned long long& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= buf.size()) return false;
+        unsigned char byte = static_cast<unsigned char>(buf[pos++]);
+        value |= static_cast<unsigned long long>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Hash of the 4 bytes at pos, used to find earlier occurrences
+size_t lzHash(const string& input, size_t pos) {
+    unsigned int v = readU32(input, pos);
+    return (v * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+// Compresses input as a sequence of (literal run, match) pairs:
+//   varint literal length, literal bytes, varint match length, varint offset
+// A match length of 0 marks the end of the stream.
+string lzCompress(const string& input) {
+    string out;
+    vector<long long> lastSeen(static_cast<size_t>(1) << LZ_HASH_BITS, -1);
+    size_t literalStart = 0;
+    size_t pos = 0;
+
+    while (pos + LZ_MIN_MATCH <= input.size()) {
+        size_t h = lzHash(input, pos);
+        long long candidate = lastSeen[h];
+        lastSeen[h] = static_cast<long long>(pos);
+
+        if (candidate >= 0 && pos - candidate <= LZ_MAX_OFFSET &&
+            input.compare(candidate, LZ_MIN_MATCH, input, pos, LZ_MIN_MATCH) == 0) {
+            size_t length = LZ_MIN_MATCH;
+            while (pos + length < input.size() && input[candidate + length] == input[pos + length]) {
+                length++;
+            }
+
+            appendVarint(out, pos - literalStart);
+            out.append(input, literalStart, pos - literalStart);
+            appendVarint(out, length);
+            appendVarint(out, pos - candidate);
+
+            // Index a few positions inside the match so later repeats are found
+            size_t end = pos + length;
+            for (size_t p = pos + 1; p < end && p + LZ_MIN_MATCH <= input.size(); p += 2) {
+                lastSeen[lzHash(input, p)] = static_cast<long long>(p);
+            }
+            pos = end;
+            literalStart = pos;
+        } else {
+            pos++;
+        }
+    }
+
+    appendVarint(out, input.size() - literalStart);
+    out.append(input, literalStart, input.size() - literalStart);
+    appendVarint(out, 0);
+    return out;
+}
+
+// Inverse of lzCompress; fails if the stream is malformed or the wrong size
+bool lzDecompress(const string& input, size_t rawSize, string& output) {
+    output.clear();
+    output.reserve(rawSize);
+    size_t pos = 0;
+    while (true) {
+        unsigned long long literals = 0;
+        unsigned long long length = 0;
+        if (!readVarint(input, pos, literals) || literals > input.size() - pos) return false;
+        output.append(input, pos, literals);
+        pos += literals;
+        if (!readVarint(input, pos, length)) return false;
+        if (length == 0) break;
+
+        unsigned long long offset = 0;
+        if (!readVarint(input, pos, offset) || offset == 0 || offset > output.size() ||
+            output.size() + length > rawSize) {
+            return false;
+        }
+        // Byte-by-byte copy so overlapping matches (offset < length) work
+        size_t from = output.size() - offset;
+        for (unsigned long long i = 0; i < length; ++i) {
+            output.push_back(output[from + i]);
+        }
+    }
+    return output.size() == rawSize && pos == input.size();
+}
+
+// Parses a "YYYY-MM-DD" command-line date into epoch milliseconds at the
+// start (or last millisecond) of that day; -1 if malformed
+long long parseDateArgument(const string& date, bool endOfDay) {
+    long long start = parseIsoTimestamp(date + "T00:00:00.000Z");
+    if (start < 0) {
+        cerr << "Error: Expected a date as YYYY-MM-DD, got " << date << endl;
+        return -1;
+    }
+    return endOfDay ? start + 86400000 - 1 : start;
+}
+
+// Keeps the rows of one senator and / or a time range (empty senator / -1
+// times = no filter), for loaders that cannot skip rows while reading
+vector<vector<string>> filterTweetRows(const vector<vector<string>>& tweets, const string& senatorFilter, long long fromMillis,
+                                       long long toMillis) {
+    vector<vector<string>> kept;
+    for (const vector<string>& row : tweets) {
+        if (row.size() < 5 || (!senatorFilter.empty() && row[3] != senatorFilter)) continue;
+        if (fromMillis >= 0 || toMillis >= 0) {
+            long long ts = parseIsoTimestamp(row[2]);
+            if (ts < 0 || (fromMillis >= 0 && ts < fromMillis) || (toMillis >= 0 && ts > toMillis)) continue;
+        }
+        kept.push_back(row);
+    }
+    return kept;
+}
+
+// Writes the tweets into the block-compressed format described above
+bool writeCompressedCorpus(const vector<vector<string>>& tweets, string path, int rowsPerBlock) {
+    vector<string> senatorNames;
+    vector<int> senatorTable;
+    string directory;
+    string blocks;
+    size_t blockCount = 0;
+
+    for (size_t first = 0; first < tweets.size(); first += rowsPerBlock) {
+        size_t last = min(tweets.size(), first + static_cast<size_t>(rowsPerBlock));
+
+        // 1. Collect block metadata: time range and the senators present
+        vector<long long> timestamps;
+        vector<unsigned int> blockSenators;
+        long long minTs = -1;
+        long long maxTs = -1;
+        for (size_t r = first; r < last; ++r) {
+            long long ts = parseIsoTimestamp(tweets[r][2]);
+            long long id = 0;
+            if (ts < 0 || formatIsoTimestamp(ts) != tweets[r][2] ||
+                !parseInt64Column(tweets[r][0], id) || !parseInt64Column(tweets[r][1], id)) {
+                cerr << "Error: Row " << r << " has an id or timestamp that cannot be stored in compressed form" << endl;
+                return false;
+            }
+            timestamps.push_back(ts);
+            if (minTs < 0 || ts < minTs) minTs = ts;
+            if (ts > maxTs) maxTs = ts;
+            blockSenators.push_back(static_cast<unsigned int>(internString(tweets[r][3], senatorNames, senatorTable)));
+        }
+
+        // 2. Encode the rows of the block
+        string raw;
+        for (size_t r = first; r < last; ++r) {
+            appendVarint(raw, static_cast<unsigned long long>(stoll(tweets[r][0])));
+            appendVarint(raw, static_cast<unsigned long long>(stoll(tweets[r][1])));
+            appendVarint(raw, static_cast<unsigned long long>(timestamps[r - first] - minTs));
+            appendVarint(raw, blockSenators[r - first]);
+            appendVarint(raw, tweets[r][4].size());
+            raw += tweets[r][4];
+        }
+        string compressed = lzCompress(raw);
+
+        sort(blockSenators.begin(), blockSenators.end());
+        blockSenators.erase(unique(blockSenators.begin(), blockSenators.end()), blockSenators.end());
+
+        // 3. Directory entry (offset is relative to the start of the blocks area)
+        appendU64(directory, blocks.size());
+        appendU32(directory, static_cast<unsigned int>(compressed.size()));
+        appendU32(directory, static_cast<unsigned int>(raw.size()));
+        appendU32(directory, static_cast<unsigned int>(last - first));
+        appendU64(directory, static_cast<unsigned long long>(minTs));
+        appendU64(directory, static_cast<unsigned long long>(maxTs));
+        appendU64(directory, fnv1aHash(compressed, 0, compressed.size()));
+        appendU32(directory, static_cast<unsigned int>(blockSenators.size()));
+        for (unsigned int id : blockSenators) appendU32(directory, id);
+
+        blocks += compressed;
+        blockCount++;
+    }
+
+    string header = "TWBZ";
+    appendU32(header, COMPRESSED_CORPUS_VERSION);
+    appendU32(header, static_cast<unsigned int>(rowsPerBlock));
+    appendU64(header, tweets.size());
+    appendU32(header, static_cast<unsigned int>(blockCount));
+    string senatorTableBytes;
+    appendStringTable(senatorTableBytes, senatorNames);
+    appendU64(header, senatorTableBytes.size());
+    appendU64(header, directory.size());
+    header += senatorTableBytes;
+    header += directory;
+    appendU64(header, fnv1aHash(header, 0, header.size()));
+
+    ofstream fout(path, ios::out | ios::binary);
+    if (!fout.is_open()) {
+        cerr << "Error: Could not create " << path << endl;
+        return false;
+    }
+    fout.write(header.data(), header.size());
+    fout.write(blocks.data(), blocks.size());
+    fout.close();
+    return true;
+}
+
+// Loads tweets from a block-compressed corpus. Only the header and directory
+// are read up front; a block is read and decompressed only if its senator list
+// and time range can match the filters (empty senator / -1 times = no filter).
+vector<vector<string>> readCompressedCorpus(string path, string senatorFilter, long long fromMillis, long long toMillis) {
+    vector<vector<string>> tweets;
+    ifstream fin(path, ios::in | ios::binary);
+    if (!fin.is_open()) {
+        cerr << "Error: Could not open " << path << endl;
+        return tweets;
+    }
+
+    // 1. Fixed header, then the senator table and directory it describes
+    fin.seekg(0, ios::end);
+    size_t fileSize = static_cast<size_t>(fin.tellg());
+    fin.seekg(0, ios::beg);
+    string header(40, '\0');
+    fin.read(&header[0], header.size());
+    if (fin.gcount() != 40 || header.compare(0, 4, "TWBZ") != 0) {
+        cerr << "Error: " << path << " is not a compressed tweet corpus" << endl;
+        return tweets;
+    }
+    if (readU32(header, 4) != COMPRESSED_CORPUS_VERSION) {
+        cerr << "Error: " << path << " has unsupported version " << readU32(header, 4) << endl;
+        return tweets;
+    }
+    size_t blockCount = readU32(header, 20);
+    size_t senatorBytes = readU64(header, 24);
+    size_t directoryBytes = readU64(header, 32);
+    // Sizes are checked against the file before anything is allocated for them
+    if (fileSize < 48 || senatorBytes > fileSize - 48 || directoryBytes > fileSize - 48 - senatorBytes) {
+        cerr << "Error: " << path << " has a corrupt header" << endl;
+        return tweets;
+    }
+    string rest(senatorBytes + directoryBytes + 8, '\0');
+    fin.read(&rest[0], rest.size());
+    header += rest;
+    size_t checksumPos = header.size() - 8;
+    if (static_cast<size_t>(fin.gcount()) != rest.size() ||
+        readU64(header, checksumPos) != fnv1aHash(header, 0, checksumPos)) {
+        cerr << "Error: " << path << " has a corrupt header" << endl;
+        return tweets;
+    }
+
+    vector<string> senatorNames;
+    if (!readStringTable(header, 40, senatorBytes, senatorNames)) {
+        cerr << "Error: " << path << " has a corrupt senator table" << endl;
+        return tweets;
+    }
+    long long wantedSenator = -1;
+    if (!senatorFilter.empty()) {
+        for (size_t i = 0; i < senatorNames.size(); ++i) {
+            if (senatorNames[i] == senatorFilter) wantedSenator = static_cast<long long>(i);
+        }
+        if (wantedSenator < 0) return tweets;
+    }
+
+    // 2. Walk the directory and load the blocks that can match; every entry
+    //    must lie inside the directory and every block inside the file
+    size_t blocksStart = header.size();
+    size_t pos = 40 + senatorBytes;
+    size_t directoryEnd = pos + directoryBytes;
+    string compressed;
+    string raw;
+    for (size_t b = 0; b < blockCount; ++b) {
+        if (directoryEnd - pos < 48 || (directoryEnd - pos - 48) / 4 < readU32(header, pos + 44)) {
+            cerr << "Error: " << path << " has a corrupt directory entry " << b << endl;
+            return tweets;
+        }
+        size_t offset = readU64(header, pos);
+        size_t compressedSize = readU32(header, pos + 8);
+        size_t rawSize = readU32(header, pos + 12);
+        size_t rows = readU32(header, pos + 16);
+        long long minTs = static_cast<long long>(readU64(header, pos + 20));
+        long long maxTs = static_cast<long long>(readU64(header, pos + 28));
+        unsigned long long checksum = readU64(header, pos + 36);
+        size_t senatorCount = readU32(header, pos + 44);
+        bool hasSenator = (wantedSenator < 0);
+        for (size_t i = 0; i < senatorCount; ++i) {
+            if (readU32(header, pos + 48 + i * 4) == wantedSenator) hasSenator = true;
+        }
+        pos += 48 + senatorCount * 4;
+        if (offset > fileSize - blocksStart || compressedSize > fileSize - blocksStart - offset) {
+            cerr << "Error: " << path << " has a corrupt directory entry " << b << endl;
+            tweets.clear();
+            return tweets;
+        }
+
+        if (!hasSenator || (fromMillis >= 0 && maxTs < fromMillis) || (toMillis >= 0 && minTs > toMillis)) {
+            continue;
+        }
+
+        compressed.assign(compressedSize, '\0');
+        fin.seekg(blocksStart + offset, ios::beg);
+        fin.read(&compressed[0], compressedSize);
+        if (static_cast<size_t>(fin.gcount()) != compressedSize ||
+            fnv1aHash(compressed, 0, compressedSize) != checksum || !lzDecompress(compressed, rawSize, raw)) {
+            cerr << "Error: " << path << " has a corrupt block " << b << endl;
+            tweets.clear();
+            return tweets;
+        }
+
+        // 3. Decode rows, applying the row-level filters
+        size_t rp = 0;
+        for (size_t r = 0; r < rows; ++r) {
+            unsigned long long id = 0, userId = 0, tsDelta = 0, senatorId = 0, textLen = 0;
+            if (!readVarint(raw, rp, id) || !readVarint(raw, rp, userId) || !readVarint(raw, rp, tsDelta) ||
+                !readVarint(raw, rp, senatorId) || !readVarint(raw, rp, textLen) ||
+                senatorId >= senatorNames.size() || textLen > raw.size() - rp) {
+                cerr << "Error: " << path << " has a corrupt row in block " << b << endl;
+                tweets.clear();
+                return tweets;
+            }
+            long long ts = minTs + static_cast<long long>(tsDelta);
+            bool keep = (wantedSenator < 0 || static_cast<long long>(senatorId) == wantedSenator) &&
+                        (fromMillis < 0 || ts >= fromMillis) && (toMillis < 0 || ts <= toMillis);
+            if (keep) {
+                vector<string> row(5);
+                row[0] = to_string(static_cast<long long>(id));
+                row[1] = to_string(static_cast<long long>(userId));
+                row[2] = formatIsoTimestamp(ts);
+                row[3] = senatorNames[senatorId];
+                row[4] = raw.substr(rp, textLen);
+                tweets.push_back(row);
+            }
+            rp += textLen;
         }
     }
     fin.close();
     return tweets;
 }
 
-// Reads an emotion word file into a vector
-vector<string> readEmotionFile(string path) {
-    vector<string> words;
-    fstream fin;
-    fin.open(path, ios::in);
-    if (!fin.is_open()) {
-        cerr << "Error: Could not open " << path << endl;
-        return words;
+// ---------------------------------------------------------------------------
+// Inverted index
+//
+// Maps each stem (of the cleaned, lowercased word) to the list of tweets that
+// contain it. Posting lists hold tweet indexes in ascending order, stored as
+// varint deltas from the previous index. Per-tweet word counts and lexicon
+// totals are recorded while indexing so a query only sums over its matching
+// tweets.
+// ---------------------------------------------------------------------------
+
+// Builds the index in one pass over the tweets. Each distinct raw token is
+// stemmed once; later occurrences reuse the cached stem id, lexicon stem hash
+// and negator flag. Tweets are scored by scoreLexiconMatches against the
+// compiled lexicon, so phrases, weights, negation and sentiment stop words
+// follow the same rules as Part 1.
+void buildInvertedIndex(const vector<vector<string>>& tweets, const vector<string>& lexiconTerms, const vector<double>& lexiconScores,
+                        const vector<string>& negators, int negationWindow, const vector<unsigned long long>& sentimentStopFilter,
+                        vector<string>& stems, vector<int>& stemTable, vector<string>& postings, vector<int>& postingCounts,
+                        vector<int>& tweetWords, vector<double>& tweetPositive, vector<double>& tweetNegative) {
+    METRIC_TIMER_BEGIN(TIMER_INDEX_BUILD);
+    vector<unsigned long long> trieKeys;
+    vector<int> trieChild;
+    vector<double> nodeWeights;
+    compileLexicon(lexiconTerms, lexiconScores, trieKeys, trieChild, nodeWeights);
+    vector<unsigned long long> negHashes = negatorHashes(negators);
+
+    stems.clear();
+    stemTable.clear();
+    postings.clear();
+    postingCounts.clear();
+    tweetWords.assign(tweets.size(), 0);
+    tweetPositive.assign(tweets.size(), 0.0);
+    tweetNegative.assign(tweets.size(), 0.0);
+
+    // Cache per distinct raw token: index stem id (-1 if too short), lexicon
+    // stem hash (0 for sentiment stop words) and negator flag
+    vector<string> tokens;
+    vector<int> tokenTable;
+    vector<int> tokenStem;
+    vector<unsigned long long> tokenLexicon;
+    vector<char> tokenNegator;
+    vector<int> lastTweet;
+    vector<unsigned long long> stemHashes;
+    vector<char> negatorFlags;
+    long long stemmedCount = 0;
+    long long indexHits = 0;
+
+    for (size_t t = 0; t < tweets.size(); ++t) {
+        stemHashes.clear();
+        negatorFlags.clear();
+        stringstream ss(tweets[t][4]);
+        string word;
+        while (ss >> word) {
+            int tokenId = internString(word, tokens, tokenTable);
+            if (tokenId == static_cast<int>(tokenStem.size())) {
+                // Same lookup rules as scoreTextSentiment: stem of the raw word
+                unsigned long long hash = termHash(word);
+                unsigned long long stemHash = 0;
+                if (!isStopWord(hash, sentimentStopFilter)) {
+                    stemHash = lexiconStemHash(stemToken(word));
+                    stemmedCount++;
+                }
+                tokenLexicon.push_back(stemHash);
+                tokenNegator.push_back(find(negHashes.begin(), negHashes.end(), hash) != negHashes.end());
+                string clean = cleanWord(word);
+                int stemId = -1;
+                if (!clean.empty()) {
+                    stemId = internString(stemString(clean), stems, stemTable);
+                    stemmedCount++;
+                    if (stemId == static_cast<int>(postings.size())) {
+                        postings.push_back("");
+                        postingCounts.push_back(0);
+                        lastTweet.push_back(-1);
+                    }
+                }
+                tokenStem.push_back(stemId);
+            }
+            stemHashes.push_back(tokenLexicon[tokenId]);
+            negatorFlags.push_back(tokenNegator[tokenId]);
+
+            int stemId = tokenStem[tokenId];
+            if (stemId >= 0 && lastTweet[stemId] != static_cast<int>(t)) {
+                appendVarint(postings[stemId], t - (lastTweet[stemId] < 0 ? 0 : lastTweet[stemId]));
+                postingCounts[stemId]++;
+                lastTweet[stemId] = static_cast<int>(t);
+            }
+        }
+        tweetWords[t] = static_cast<int>(stemHashes.size());
+        indexHits += scoreLexiconMatches(stemHashes, negatorFlags, trieKeys, trieChild, nodeWeights, negationWindow,
+                                         tweetPositive[t], tweetNegative[t]);
     }
+    long long indexTokens = 0;
+    for (size_t t = 0; t < tweets.size(); ++t) indexTokens += tweetWords[t];
+    METRIC_ADD(COUNTER_TOKENS, indexTokens);
+    METRIC_ADD(COUNTER_STEMS, stemmedCount);
+    METRIC_ADD(COUNTER_LEXICON_HITS, indexHits);
+    METRIC_TIMER_END(TIMER_INDEX_BUILD);
+}
 
-    string word;
-    while (fin >> word) {
-        words.push_back(word);
+// Decodes a delta-encoded posting list back into tweet indexes
+vector<int> decodePostings(const string& list) {
+    vector<int> tweetIds;
+    size_t pos = 0;
+    unsigned long long delta = 0;
+    long long current = 0;
+    while (readVarint(list, pos, delta)) {
+        current += static_cast<long long>(delta);
+        tweetIds.push_back(static_cast<int>(current));
     }
-    fin.close();
-    return words;
+    return tweetIds;
 }
 
-// Returns a vector of unique senator names
-vector<string> getUniqueSenators(const vector<vector<string>>& tweets) {
-    vector<string> senators;
-    for (const auto& row : tweets) {
-        if (row.size() >= 4) {
-            string name = row[3];
-            bool found = false;
-            for (const string& s : senators) {
-                if (s == name) {
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
-                senators.push_back(name);
+// Returns the tweets containing every term. Lists are intersected from the
+// rarest term up so the working set only shrinks. postingsDecoded reports how
+// many posting entries were touched.
+vector<int> intersectPostings(const vector<string>& terms, const vector<string>& stems, const vector<int>& stemTable,
+                              const vector<string>& postings, const vector<int>& postingCounts, long long& postingsDecoded) {
+    vector<int> result;
+    postingsDecoded = 0;
+    if (terms.empty() || stemTable.empty()) return result;
+
+    // 1. Look up the stem id of every term
+    vector<int> termStems;
+    size_t mask = stemTable.size() - 1;
+    for (const string& term : terms) {
+        string clean = cleanWord(term);
+        if (clean.empty()) continue;
+        string stemmed = stemString(clean);
+        size_t slot = fnv1aHash(stemmed, 0, stemmed.size()) & mask;
+        int found = -1;
+        while (stemTable[slot] != -1) {
+            if (stems[stemTable[slot]] == stemmed) {
+                found = stemTable[slot];
+                break;
             }
+            slot = (slot + 1) & mask;
         }
+        if (found == -1) return result;
+        termStems.push_back(found);
     }
-    // Sort for consistent output
-    sort(senators.begin(), senators.end());
-    return senators;
+    if (termStems.empty()) return result;
+
+    // 2. Rarest first
+    sort(termStems.begin(), termStems.end(), [&](int a, int b) { return postingCounts[a] < postingCounts[b]; });
+
+    result = decodePostings(postings[termStems[0]]);
+    postingsDecoded += result.size();
+    for (size_t i = 1; i < termStems.size() && !result.empty(); ++i) {
+        vector<int> next = decodePostings(postings[termStems[i]]);
+        postingsDecoded += next.size();
+        vector<int> merged;
+        set_intersection(result.begin(), result.end(), next.begin(), next.end(), back_inserter(merged));
+        result.swap(merged);
+    }
+    return result;
 }
 
-// Helper to determine party affiliation
-string getParty(string senator) {
-    // Hardcoded mapping based on known affiliations of the senators in the dataset
-    if (senator == "Dan Sullivan" || senator == "Cory Gardner" || senator == "Jeff Flake" || 
-        senator == "John Boozman" || senator == "Jon Kyl" || senator == "Lisa Murkowski" || 
-        senator == "Richard Shelby" || senator == "Tom Cotton") {
-        return "Republican";
+// Prints the sentiment of the tweets that mention all of the query terms
+void queryTermSentiment(const vector<string>& terms, const vector<string>& stems, const vector<int>& stemTable,
+                        const vector<string>& postings, const vector<int>& postingCounts,
+                        const vector<int>& tweetWords, const vector<double>& tweetPositive, const vector<double>& tweetNegative) {
+    long long postingsDecoded = 0;
+    vector<int> matches = intersectPostings(terms, stems, stemTable, postings, postingCounts, postingsDecoded);
+
+    int totalWords = 0;
+    double posCount = 0;
+    double negCount = 0;
+    for (int t : matches) {
+        totalWords += tweetWords[t];
+        posCount += tweetPositive[t];
+        negCount += tweetNegative[t];
+    }
+
+    cout << "Query:";
+    for (const string& term : terms) cout << " " << term;
+    cout << endl;
+    double touched = tweetWords.empty() ? 0.0 : static_cast<double>(postingsDecoded) / tweetWords.size() * 100.0;
+    cout << "Found " << matches.size() << " matching tweets (" << postingsDecoded << " postings decoded, "
+         << fixed << setprecision(2) << touched << "% of corpus)." << endl;
+    if (totalWords > 0) {
+        double posPct = posCount / totalWords * 100.0;
+        double negPct = negCount / totalWords * 100.0;
+        cout << setprecision(5) << "Positive %: " << posPct << endl;
+        cout << "Negative %: " << negPct << endl;
     } else {
-        return "Democrat";
+        cout << "No words found in matching tweets." << endl;
     }
 }
 
-// Part 1: Calculates and prints sentiment percentages
-void calculateSentiment(const vector<vector<string>>& tweets, const vector<string>& senators, const vector<string>& positiveWords, const vector<string>& negativeWords) {
-    // Pre-stem emotion words for efficiency
-    vector<string> stemmedPositive;
-    vector<string> stemmedNegative;
+// ---------------------------------------------------------------------------
+// Query server
+//
+// Loads the corpus once, builds the inverted index, per-senator prefix sums
+// over time-ordered tweets and the alignment model, then answers one request
+// per input line until "quit" or end of input:
+//
+//   senator <name>                      sentiment over all of a senator's tweets
+//   range <name> <YYYY-MM-DD> <YYYY-MM-DD>  sentiment over a date range
+//   entity <term> [term...]             sentiment of tweets mentioning all terms
+//   predict <text>                      predicted party of the text
+//   help | quit
+//
+// Each reply is a single "OK ..." or "ERR ..." line ending in time_us=<n>.
+// Attach it to a socket with e.g. socat for remote clients.
+// ---------------------------------------------------------------------------
 
-    for (const string& w : positiveWords) {
-        stemmedPositive.push_back(stemString(w));
-    }
-    for (const string& w : negativeWords) {
-        stemmedNegative.push_back(stemString(w));
+// Formats "tweets= positive= negative=" fields for a reply line
+string formatSentimentReply(long long tweetCount, long long words, double positive, double negative) {
+    stringstream ss;
+    double posPct = (words > 0) ? positive / words * 100.0 : 0.0;
+    double negPct = (words > 0) ? negative / words * 100.0 : 0.0;
+    ss << "tweets=" << tweetCount << " words=" << words << fixed << setprecision(5)
+       << " positive=" << posPct << " negative=" << negPct;
+    return ss.str();
+}
+
+void runQueryServer(const vector<vector<string>>& tweets, const vector<string>& lexiconTerms, const vector<double>& lexiconScores,
+                    const vector<string>& negators, int negationWindow, const vector<unsigned long long>& sentimentStopFilter,
+                    const vector<unsigned long long>& stopFilter, int maxNgram, istream& in, ostream& out) {
+    // 1. Inverted index and per-tweet sentiment totals
+    vector<string> stems, postings;
+    vector<int> stemTable, postingCounts, tweetWords;
+    vector<double> tweetPositive, tweetNegative;
+    buildInvertedIndex(tweets, lexiconTerms, lexiconScores, negators, negationWindow, sentimentStopFilter, stems, stemTable,
+                       postings, postingCounts, tweetWords, tweetPositive, tweetNegative);
+
+    // 2. Per senator: timestamps in order plus prefix sums of the counts, so
+    //    any date range is two binary searches and three subtractions
+    vector<string> senatorNames;
+    vector<int> senatorTable;
+    vector<vector<int>> senatorTweets;
+    for (size_t t = 0; t < tweets.size(); ++t) {
+        int id = internString(tweets[t][3], senatorNames, senatorTable);
+        if (id == static_cast<int>(senatorTweets.size())) senatorTweets.push_back(vector<int>());
+        senatorTweets[id].push_back(static_cast<int>(t));
     }
+    vector<long long> tweetTimes(tweets.size());
+    for (size_t t = 0; t < tweets.size(); ++t) tweetTimes[t] = parseIsoTimestamp(tweets[t][2]);
 
-    // Sort for binary search
-    sort(stemmedPositive.begin(), stemmedPositive.end());
-    sort(stemmedNegative.begin(), stemmedNegative.end());
+    vector<vector<long long>> senatorTimes(senatorNames.size());
+    vector<vector<long long>> prefixWords(senatorNames.size());
+    vector<vector<double>> prefixPositive(senatorNames.size());
+    vector<vector<double>> prefixNegative(senatorNames.size());
+    for (size_t s = 0; s < senatorNames.size(); ++s) {
+        vector<int>& list = senatorTweets[s];
+        stable_sort(list.begin(), list.end(), [&](int a, int b) { return tweetTimes[a] < tweetTimes[b]; });
+        prefixWords[s].assign(1, 0);
+        prefixPositive[s].assign(1, 0);
+        prefixNegative[s].assign(1, 0);
+        for (int t : list) {
+            senatorTimes[s].push_back(tweetTimes[t]);
+            prefixWords[s].push_back(prefixWords[s].back() + tweetWords[t]);
+            prefixPositive[s].push_back(prefixPositive[s].back() + tweetPositive[t]);
+            prefixNegative[s].push_back(prefixNegative[s].back() + tweetNegative[t]);
+        }
+    }
 
-    cout << left << setw(20) << "Senator" << right << setw(15) << "Positive %" << setw(15) << "Negative %" << endl;
-    cout << string(50, '-') << endl;
+    // 3. Alignment model, frozen into the hashed scorer
+    vector<string> keyTerms;
+    vector<string> keyTermParty;
+    trainAlignmentModel(tweets, stopFilter, keyTerms, keyTermParty, maxNgram);
+    vector<unsigned long long> scorerKeys;
+    vector<double> scorerWeights;
+    vector<unsigned char> scorerFlags;
+    buildAlignmentScorer(keyTerms, keyTermWeights(keyTermParty), negators, scorerKeys, scorerWeights, scorerFlags);
 
-    for (const string& senator : senators) {
-        int totalWords = 0;
-        int posCount = 0;
-        int negCount = 0;
+    out << "READY tweets=" << tweets.size() << " senators=" << senatorNames.size() << " stems=" << stems.size() << endl;
 
-        for (const auto& row : tweets) {
-            if (row[3] == senator) {
-                stringstream ss(row[4]);
-                string word;
-                while (ss >> word) {
-                    string stemmed = stemString(word);
-                    totalWords++;
+    // 4. Request loop
+    string line;
+    while (getline(in, line)) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        stringstream ss(line);
+        string command;
+        ss >> command;
+        vector<string> args;
+        string arg;
+        while (ss >> arg) args.push_back(arg);
 
-                    if (binary_search(stemmedPositive.begin(), stemmedPositive.end(), stemmed)) {
-                        posCount++;
-                    }
-                    if (binary_search(stemmedNegative.begin(), stemmedNegative.end(), stemmed)) {
-                        negCount++;
+        string reply;
+        if (command.empty()) {
+            continue;
+        } else if (command == "quit") {
+            break;
+        } else if (command == "help") {
+            reply = "OK commands=senator,range,entity,predict,quit";
+        } else if (command == "senator" || command == "range") {
+            // The senator name is every argument except the two trailing dates
+            size_t nameParts = args.size() - ((command == "range") ? 2 : 0);
+            long long fromMillis = 0;
+            long long toMillis = 0;
+            if (args.empty() || (command == "range" && args.size() < 3)) {
+                reply = "ERR usage: " + command + (command == "range" ? " <name> <from> <to>" : " <name>");
+            } else if (command == "range" &&
+                       ((fromMillis = parseDateArgument(args[nameParts], false)) < 0 ||
+                        (toMillis = parseDateArgument(args[nameParts + 1], true)) < 0)) {
+                reply = "ERR dates must be YYYY-MM-DD";
+            } else {
+                string name = args[0];
+                for (size_t i = 1; i < nameParts; ++i) name += " " + args[i];
+                int id = -1;
+                for (size_t s = 0; s < senatorNames.size(); ++s) {
+                    if (senatorNames[s] == name) id = static_cast<int>(s);
+                }
+                if (id < 0) {
+                    reply = "ERR unknown senator " + name;
+                } else {
+                    size_t lo = 0;
+                    size_t hi = senatorTimes[id].size();
+                    if (command == "range") {
+                        lo = lower_bound(senatorTimes[id].begin(), senatorTimes[id].end(), fromMillis) - senatorTimes[id].begin();
+                        hi = upper_bound(senatorTimes[id].begin(), senatorTimes[id].end(), toMillis) - senatorTimes[id].begin();
+                        if (hi < lo) hi = lo;
                     }
+                    reply = "OK " + formatSentimentReply(static_cast<long long>(hi - lo),
+                                                         prefixWords[id][hi] - prefixWords[id][lo],
+                                                         prefixPositive[id][hi] - prefixPositive[id][lo],
+                                                         prefixNegative[id][hi] - prefixNegative[id][lo]);
                 }
             }
+        } else if (command == "entity") {
+            long long postingsDecoded = 0;
+            vector<int> matches = intersectPostings(args, stems, stemTable, postings, postingCounts, postingsDecoded);
+            long long words = 0;
+            double positive = 0, negative = 0;
+            for (int t : matches) {
+                words += tweetWords[t];
+                positive += tweetPositive[t];
+                negative += tweetNegative[t];
+            }
+            reply = "OK " + formatSentimentReply(static_cast<long long>(matches.size()), words, positive, negative);
+        } else if (command == "predict") {
+            size_t textStart = line.find("predict") + 7;
+            reply = "OK party=" + predictionParty(predictWithScorer(line.substr(textStart), scorerKeys, scorerWeights, scorerFlags, negationWindow));
+        } else {
+            reply = "ERR unknown command " + command;
         }
 
-        double posPct = (totalWords > 0) ? static_cast<double>(posCount) / totalWords * 100.0 : 0.0;
-        double negPct = (totalWords > 0) ? static_cast<double>(negCount) / totalWords * 100.0 : 0.0;
+        long long micros = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+        // One flush per reply so interactive clients see the answer immediately
+        out << reply << " time_us=" << micros << endl;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark suite
+//
+// Generates synthetic corpora of the requested sizes whose senators,
+// timestamps, tweet lengths and words are sampled from the loaded corpus
+// (words from the tweeting senator's party, so the alignment stages see a
+// realistic signal), then times each pipeline stage on its own: load (CSV
+// parse), tokenize, stem, lexicon lookup, per-senator aggregation, alignment
+// train and alignment predict. Rows are generated and processed in batches
+// of BENCH_BATCH_ROWS so memory stays bounded at 100M rows; stage times are
+// summed over the batches and the alignment model is trained per batch.
+// The generator is seeded, so a size always produces the same corpus.
+// Results are printed one line per stage as key=value pairs.
+// ---------------------------------------------------------------------------
 
-        cout << left << setw(20) << senator << right << setw(15) << fixed << setprecision(5) << posPct << setw(15) << negPct << endl;
+const unsigned long long BENCH_SEED = 20251210;
+const long long BENCH_BATCH_ROWS = 250000;
+
+// Peak resident set size of this process (VmHWM), or -1 where /proc is unavailable
+long long peakRssKb() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) return atoll(line.c_str() + 6);
     }
+    return -1;
 }
 
-// Part 2 - Capability 1: Most Talkative Senator
-void findMostTalkative(const vector<vector<string>>& tweets, const vector<string>& senators) {
-    string mostTweetsSenator;
-    int maxTweets = -1;
+// Next draw in [0, n) from a 64-bit LCG
+inline size_t benchDraw(unsigned long long& state, size_t n) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<size_t>((state >> 33) % n);
+}
 
-    string mostWordsSenator;
-    double maxAvgWords = -1.0;
+// Writes `rows` synthetic CSV rows (with header) into a single string
+string generateSyntheticBatch(const vector<vector<string>>& tweets, const vector<int>& tweetLengths,
+                              const vector<string>& republicanWords, const vector<string>& democratWords,
+                              long long firstId, long long rows, unsigned long long& state) {
+    string csv = "|user_id|created_at|senator_name|text\n";
+    for (long long r = 0; r < rows; ++r) {
+        const vector<string>& sample = tweets[benchDraw(state, tweets.size())];
+        const vector<string>& words = (getParty(sample[3]) == "Republican") ? republicanWords : democratWords;
+        csv += to_string(firstId + r) + "|" + sample[1] + "|" + sample[2] + "|" + sample[3] + "|";
+        int length = tweetLengths[benchDraw(state, tweetLengths.size())];
+        for (int w = 0; w < length && !words.empty(); ++w) {
+            if (w > 0) csv += ' ';
+            csv += words[benchDraw(state, words.size())];
+        }
+        csv += '\n';
+    }
+    return csv;
+}
+
+void runBenchmarks(const vector<vector<string>>& tweets, const vector<string>& lexiconTerms, const vector<double>& lexiconScores,
+                   const vector<string>& negators, int negationWindow, const vector<unsigned long long>& sentimentStopFilter,
+                   const vector<unsigned long long>& stopFilter, const vector<long long>& sizes, ostream& out) {
+    // 1. Sampling pools: every token occurrence per party and every tweet length
+    vector<string> republicanWords, democratWords;
+    vector<int> tweetLengths;
+    vector<vector<string>> samples;
+    for (const auto& row : tweets) {
+        if (row.size() < 5) continue;
+        samples.push_back(row);
+        vector<string>& words = (getParty(row[3]) == "Republican") ? republicanWords : democratWords;
+        stringstream ss(row[4]);
+        string word;
+        int length = 0;
+        while (ss >> word) {
+            words.push_back(word);
+            length++;
+        }
+        tweetLengths.push_back(length);
+    }
+    if (samples.empty()) {
+        cerr << "Error: --bench needs a loaded corpus to sample from" << endl;
+        return;
+    }
 
-    cout << left << setw(20) << "Senator" << right << setw(15) << "Tweet Count" << setw(20) << "Avg Words/Tweet" << endl;
+    vector<unsigned long long> trieKeys;
+    vector<int> trieChild;
+    vector<double> nodeWeights;
+    compileLexicon(lexiconTerms, lexiconScores, trieKeys, trieChild, nodeWeights);
+    vector<unsigned long long> negHashes = negatorHashes(negators);
+    const char* stageNames[] = {"load", "tokenize", "stem", "lexicon", "aggregate", "train", "predict"};
+    const int STAGES = 7;
 
-    for (const string& senator : senators) {
-        int tweetCount = 0;
-        int totalWords = 0;
+    for (long long size : sizes) {
+        vector<double> seconds(STAGES, 0.0);
+        long long totalTokens = 0;
+        long long checksum = 0;  // keeps every stage's results live
+        unsigned long long state = BENCH_SEED;
 
-        for (const auto& row : tweets) {
-            if (row[3] == senator) {
-                tweetCount++;
+        for (long long firstId = 0; firstId < size; firstId += BENCH_BATCH_ROWS) {
+            long long rows = min(BENCH_BATCH_ROWS, size - firstId);
+            string csv = generateSyntheticBatch(samples, tweetLengths, republicanWords, democratWords, firstId, rows, state);
+
+            // Load
+            auto t0 = chrono::steady_clock::now();
+            istringstream csvStream(csv);
+            vector<vector<string>> batch = parseTweetsCsv(csvStream);
+            auto t1 = chrono::steady_clock::now();
+            seconds[0] += chrono::duration<double>(t1 - t0).count();
+            csv.clear();
+            csv.shrink_to_fit();
+
+            // Tokenize
+            vector<string> tokens;
+            vector<long long> tokenOffsets(1, 0);
+            for (const auto& row : batch) {
                 stringstream ss(row[4]);
                 string word;
-                while (ss >> word) {
-                    totalWords++;
-                }
+                while (ss >> word) tokens.push_back(word);
+                tokenOffsets.push_back(static_cast<long long>(tokens.size()));
             }
-        }
+            auto t2 = chrono::steady_clock::now();
+            seconds[1] += chrono::duration<double>(t2 - t1).count();
+            totalTokens += static_cast<long long>(tokens.size());
 
-        double avgWords = (tweetCount > 0) ? static_cast<double>(totalWords) / tweetCount : 0.0;
+            // Stem, skipping sentiment stop words as Part 1 does (hash 0 = not looked up)
+            vector<unsigned long long> stemHashes(tokens.size(), 0);
+            vector<char> negatorFlags(tokens.size(), 0);
+            for (size_t k = 0; k < tokens.size(); ++k) {
+                unsigned long long hash = termHash(tokens[k]);
+                if (!isStopWord(hash, sentimentStopFilter)) stemHashes[k] = lexiconStemHash(stemToken(tokens[k]));
+                negatorFlags[k] = find(negHashes.begin(), negHashes.end(), hash) != negHashes.end();
+            }
+            auto t3 = chrono::steady_clock::now();
+            seconds[2] += chrono::duration<double>(t3 - t2).count();
 
-        cout << left << setw(20) << senator << right << setw(15) << tweetCount << setw(20) << fixed << setprecision(2) << avgWords << endl;
+            // Lexicon matching per tweet through the compiled trie, with phrases and negation
+            vector<double> tweetPositive(batch.size(), 0.0);
+            vector<double> tweetNegative(batch.size(), 0.0);
+            vector<unsigned long long> tweetHashes;
+            vector<char> tweetNegators;
+            for (size_t t = 0; t < batch.size(); ++t) {
+                tweetHashes.assign(stemHashes.begin() + tokenOffsets[t], stemHashes.begin() + tokenOffsets[t + 1]);
+                tweetNegators.assign(negatorFlags.begin() + tokenOffsets[t], negatorFlags.begin() + tokenOffsets[t + 1]);
+                scoreLexiconMatches(tweetHashes, tweetNegators, trieKeys, trieChild, nodeWeights, negationWindow,
+                                    tweetPositive[t], tweetNegative[t]);
+            }
+            auto t4 = chrono::steady_clock::now();
+            seconds[3] += chrono::duration<double>(t4 - t3).count();
 
-        if (tweetCount > maxTweets) {
-            maxTweets = tweetCount;
-            mostTweetsSenator = senator;
+            // Per-senator aggregation of word counts and lexicon totals
+            vector<string> senatorNames;
+            vector<int> senatorTable;
+            vector<long long> senatorWords;
+            vector<double> senatorPositive, senatorNegative;
+            for (size_t t = 0; t < batch.size(); ++t) {
+                int id = internString(batch[t][3], senatorNames, senatorTable);
+                if (id == static_cast<int>(senatorWords.size())) {
+                    senatorWords.push_back(0);
+                    senatorPositive.push_back(0);
+                    senatorNegative.push_back(0);
+                }
+                senatorWords[id] += tokenOffsets[t + 1] - tokenOffsets[t];
+                senatorPositive[id] += tweetPositive[t];
+                senatorNegative[id] += tweetNegative[t];
+            }
+            auto t5 = chrono::steady_clock::now();
+            seconds[4] += chrono::duration<double>(t5 - t4).count();
+            for (size_t id = 0; id < senatorWords.size(); ++id) {
+                checksum += senatorWords[id] + static_cast<long long>(senatorPositive[id] + senatorNegative[id]);
+            }
+
+            // Alignment train
+            vector<string> keyTerms, keyTermParty;
+            trainAlignmentModel(batch, stopFilter, keyTerms, keyTermParty);
+            auto t6 = chrono::steady_clock::now();
+            seconds[5] += chrono::duration<double>(t6 - t5).count();
+
+            // Alignment predict
+            vector<unsigned long long> scorerKeys;
+            vector<double> scorerWeights;
+            vector<unsigned char> scorerFlags;
+            buildAlignmentScorer(keyTerms, keyTermWeights(keyTermParty), negators, scorerKeys, scorerWeights, scorerFlags);
+            for (const auto& row : batch) {
+                checksum += predictWithScorer(row[4], scorerKeys, scorerWeights, scorerFlags, negationWindow);
+            }
+            auto t7 = chrono::steady_clock::now();
+            seconds[6] += chrono::duration<double>(t7 - t6).count();
         }
-        if (avgWords > maxAvgWords) {
-            maxAvgWords = avgWords;
-            mostWordsSenator = senator;
+
+        long long rssKb = peakRssKb();
+        for (int stage = 0; stage < STAGES; ++stage) {
+            double s = seconds[stage];
+            out << "bench rows=" << size << " stage=" << stageNames[stage] << fixed << setprecision(6) << " seconds=" << s
+                << setprecision(0) << " rows_per_s=" << (s > 0 ? size / s : 0.0)
+                << " tokens_per_s=" << (s > 0 ? totalTokens / s : 0.0) << " tokens=" << totalTokens
+                << " peak_rss_kb=" << rssKb << endl;
         }
+        cerr << "bench rows=" << size << " checksum=" << checksum << endl;
     }
-
-    cout << endl;
-    cout << "Most tweets: " << mostTweetsSenator << " (" << maxTweets << ")" << endl;
-    cout << "Highest average word count: " << mostWordsSenator << " (" << maxAvgWords << ")" << endl;
 }
 
-// Part 2 - Capability 2: Biden Sentiment
-void analyzeBidenSentiment(const vector<vector<string>>& tweets, const vector<string>& positiveWords, const vector<string>& negativeWords) {
-    // Pre-stem emotion words
-    vector<string> stemmedPositive;
-    vector<string> stemmedNegative;
-
-    for (const string& w : positiveWords) {
-        stemmedPositive.push_back(stemString(w));
+// Accumulator microbenchmark: per-senator tweet and word counts for `rows`
+// synthetic rows (senators and lengths sampled from the loaded corpus) on
+// the work-stealing pool at 1, 2, 4, ... maxThreads workers, in three
+// layouts: one shared table of atomic counters, per-worker replicas packed
+// back to back (neighbouring workers share cache lines), and the padded
+// structure-of-arrays accumulators. Prints one line per run as key=value
+// pairs, with the speedup over the same layout on one worker.
+void benchAccumulators(const vector<vector<string>>& tweets, const vector<string>& senators, int maxThreads, long long rows,
+                       ostream& out) {
+    vector<int> sampleSenators, sampleWords;
+    for (const auto& row : tweets) {
+        if (row.size() < 5) continue;
+        size_t s = lower_bound(senators.begin(), senators.end(), row[3]) - senators.begin();
+        if (s >= senators.size() || senators[s] != row[3]) continue;
+        stringstream ss(row[4]);
+        string word;
+        int length = 0;
+        while (ss >> word) length++;
+        sampleSenators.push_back(static_cast<int>(s));
+        sampleWords.push_back(length);
     }
-    for (const string& w : negativeWords) {
-        stemmedNegative.push_back(stemString(w));
+    if (sampleSenators.empty() || rows <= 0) {
+        cerr << "Error: --bench-accumulators needs a loaded corpus to sample from" << endl;
+        return;
     }
-    sort(stemmedPositive.begin(), stemmedPositive.end());
-    sort(stemmedNegative.begin(), stemmedNegative.end());
 
-    int totalWords = 0;
-    int posCount = 0;
-    int negCount = 0;
-    int bidenTweetCount = 0;
+    size_t senatorCount = senators.size();
+    vector<int> rowSenator(rows), rowWords(rows);
+    unsigned long long state = BENCH_SEED;
+    long long expected = 0;
+    for (long long r = 0; r < rows; ++r) {
+        size_t pick = benchDraw(state, sampleSenators.size());
+        rowSenator[r] = sampleSenators[pick];
+        rowWords[r] = sampleWords[pick];
+        expected += 1 + sampleWords[pick];
+    }
+    int tasks = static_cast<int>((rows + POOL_TASK_ROWS - 1) / POOL_TASK_ROWS);
+    const char* layoutNames[] = {"shared", "packed", "padded"};
+    vector<double> oneThread(3, 0.0);
+    out << "bench accumulators rows=" << rows << " senators=" << senatorCount
+        << " hardware_threads=" << thread::hardware_concurrency() << endl;
 
-    for (const auto& row : tweets) {
-        string text = row[4];
-        // Simple case-insensitive check for "Biden"
-        string lowerText = text;
-        transform(lowerText.begin(), lowerText.end(), lowerText.begin(), ::tolower);
-        
-        if (lowerText.find("biden") != string::npos) {
-            bidenTweetCount++;
-            stringstream ss(text);
-            string word;
-            while (ss >> word) {
-                string stemmed = stemString(word);
-                totalWords++;
-                if (binary_search(stemmedPositive.begin(), stemmedPositive.end(), stemmed)) {
-                    posCount++;
-                }
-                if (binary_search(stemmedNegative.begin(), stemmedNegative.end(), stemmed)) {
-                    negCount++;
+    for (int threads = 1; threads <= maxThreads; threads = (threads * 2 > maxThreads && threads < maxThreads) ? maxThreads : threads * 2) {
+        for (int layout = 0; layout < 3; ++layout) {
+            long long total = 0;
+            auto start = chrono::steady_clock::now();
+            if (layout == 0) {
+                vector<atomic<int>> shared(senatorCount * 2);
+                for (atomic<int>& counter : shared) counter.store(0, memory_order_relaxed);
+                runStealingPool(tasks, threads, [&](int, int t) {
+                    long long rowEnd = min(rows, static_cast<long long>(t + 1) * POOL_TASK_ROWS);
+                    for (long long r = static_cast<long long>(t) * POOL_TASK_ROWS; r < rowEnd; ++r) {
+                        shared[rowSenator[r] * 2].fetch_add(1, memory_order_relaxed);
+                        shared[rowSenator[r] * 2 + 1].fetch_add(rowWords[r], memory_order_relaxed);
+                    }
+                });
+                for (atomic<int>& counter : shared) total += counter.load(memory_order_relaxed);
+            } else if (layout == 1) {
+                vector<int> packed(static_cast<size_t>(threads) * senatorCount * 2, 0);
+                runStealingPool(tasks, threads, [&](int w, int t) {
+                    int* counts = &packed[static_cast<size_t>(w) * senatorCount * 2];
+                    long long rowEnd = min(rows, static_cast<long long>(t + 1) * POOL_TASK_ROWS);
+                    for (long long r = static_cast<long long>(t) * POOL_TASK_ROWS; r < rowEnd; ++r) {
+                        counts[rowSenator[r] * 2]++;
+                        counts[rowSenator[r] * 2 + 1] += rowWords[r];
+                    }
+                });
+                for (int count : packed) total += count;
+            } else {
+                vector<int> counts;
+                size_t base = initAccumulators(counts, threads, 2, senatorCount);
+                runStealingPool(tasks, threads, [&](int w, int t) {
+                    int* tweetCounts = accumulatorColumn(counts, base, w, 0, 2, senatorCount);
+                    int* wordCounts = accumulatorColumn(counts, base, w, 1, 2, senatorCount);
+                    long long rowEnd = min(rows, static_cast<long long>(t + 1) * POOL_TASK_ROWS);
+                    for (long long r = static_cast<long long>(t) * POOL_TASK_ROWS; r < rowEnd; ++r) {
+                        tweetCounts[rowSenator[r]]++;
+                        wordCounts[rowSenator[r]] += rowWords[r];
+                    }
+                });
+                mergeAccumulators(counts, base, threads, 2, senatorCount);
+                for (int column = 0; column < 2; ++column) {
+                    const int* merged = accumulatorColumn(counts, base, 0, column, 2, senatorCount);
+                    for (size_t s = 0; s < senatorCount; ++s) total += merged[s];
                 }
             }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (threads == 1) oneThread[layout] = seconds;
+            if (total != expected) cerr << "Error: " << layoutNames[layout] << " accumulators lost updates" << endl;
+            out << "bench accumulators threads=" << threads << " layout=" << layoutNames[layout] << fixed << setprecision(6)
+                << " seconds=" << seconds << setprecision(0) << " rows_per_s=" << (seconds > 0 ? rows / seconds : 0.0)
+                << setprecision(2) << " speedup=" << (seconds > 0 ? oneThread[layout] / seconds : 0.0) << endl;
         }
     }
+}
 
-    cout << "Found " << bidenTweetCount << " tweets mentioning Biden." << endl;
-    if (totalWords > 0) {
-        double posPct = static_cast<double>(posCount) / totalWords * 100.0;
-        double negPct = static_cast<double>(negCount) / totalWords * 100.0;
-        cout << "Positive %: " << posPct << endl;
-        cout << "Negative %: " << negPct << endl;
-        
-        if (posPct > negPct) {
-            cout << "Conclusion: Tweets about Biden are mostly POSITIVE." << endl;
-        } else if (negPct > posPct) {
-            cout << "Conclusion: Tweets about Biden are mostly NEGATIVE." << endl;
-        } else {
-            cout << "Conclusion: Tweets about Biden are NEUTRAL." << endl;
+// ---------------------------------------------------------------------------
+// Instrumentation
+//
+// Built with -DTWEET_METRICS, the METRIC_* macros feed relaxed atomic
+// counters and per-stage timers (total nanoseconds and call count). Hot
+// loops keep local tallies and add them once per call, so the cost is a few
+// atomic adds per tweet at most. The totals are written at exit and, when
+// SIGUSR1 arrives, at the next stage boundary (the handler only sets a flag),
+// as JSON or Prometheus text. Without the define every macro is empty and
+// --metrics only reports that metrics were not compiled in.
+// ---------------------------------------------------------------------------
+
+const char* const COUNTER_NAMES[COUNTER_COUNT] = {"rows_parsed", "tokens", "stems", "lexicon_hits", "vocab_size", "predictions",
+                                                  "queue_waits", "pool_tasks", "pool_steals", "pool_busy_max_us",
+                                                  "pool_busy_mean_us", "duplicates"};
+const char* const TIMER_NAMES[TIMER_COUNT] = {"load", "parse_csv", "sentiment", "talkative", "biden", "alignment",
+                                              "alignment_train", "tokenize_alignment", "index_build", "predict", "dedup"};
+
+#ifdef TWEET_METRICS
+atomic<long long> metricCounters[COUNTER_COUNT];
+atomic<long long> metricTimerNanos[TIMER_COUNT];
+atomic<long long> metricTimerCalls[TIMER_COUNT];
+volatile sig_atomic_t metricsDumpRequested = 0;
+bool metricsPrometheus = false;
+string metricsPath;
+
+// Writes every counter and timer in the configured format
+void dumpMetrics(ostream& out) {
+    if (metricsPrometheus) {
+        for (int c = 0; c < COUNTER_COUNT; ++c) {
+            out << "# TYPE tweets_" << COUNTER_NAMES[c] << (c == COUNTER_VOCAB_SIZE ? " gauge\n" : "_total counter\n");
+            out << "tweets_" << COUNTER_NAMES[c] << (c == COUNTER_VOCAB_SIZE ? " " : "_total ") << metricCounters[c].load() << "\n";
+        }
+        out << "# TYPE tweets_stage_seconds_total counter\n";
+        for (int t = 0; t < TIMER_COUNT; ++t) {
+            out << "tweets_stage_seconds_total{stage=\"" << TIMER_NAMES[t] << "\"} " << metricTimerNanos[t].load() / 1e9 << "\n";
+        }
+        out << "# TYPE tweets_stage_calls_total counter\n";
+        for (int t = 0; t < TIMER_COUNT; ++t) {
+            out << "tweets_stage_calls_total{stage=\"" << TIMER_NAMES[t] << "\"} " << metricTimerCalls[t].load() << "\n";
         }
     } else {
-        cout << "No words found in Biden tweets." << endl;
+        out << "{\"counters\":{";
+        for (int c = 0; c < COUNTER_COUNT; ++c) {
+            out << (c > 0 ? "," : "") << "\"" << COUNTER_NAMES[c] << "\":" << metricCounters[c].load();
+        }
+        out << "},\"timers\":{";
+        for (int t = 0; t < TIMER_COUNT; ++t) {
+            out << (t > 0 ? "," : "") << "\"" << TIMER_NAMES[t] << "\":{\"calls\":" << metricTimerCalls[t].load()
+                << ",\"seconds\":" << metricTimerNanos[t].load() / 1e9 << "}";
+        }
+        out << "}}\n";
     }
+    out.flush();
 }
 
-// Extra Credit: Political Alignment Analysis
-void analyzePoliticalAlignment(const vector<vector<string>>& tweets, const vector<string>& senators) {
-    // 1. Build Vocabulary and Counts
-    vector<string> vocab;
-    vector<int> repCounts;
-    vector<int> demCounts;
-    
-    // Common stop words to filter out
-    vector<string> stopWords;
-    stopWords.push_back("the"); stopWords.push_back("is"); stopWords.push_back("and"); stopWords.push_back("to");
-    stopWords.push_back("of"); stopWords.push_back("a"); stopWords.push_back("in"); stopWords.push_back("for");
-    stopWords.push_back("on"); stopWords.push_back("with"); stopWords.push_back("at"); stopWords.push_back("by");
-    stopWords.push_back("from"); stopWords.push_back("up"); stopWords.push_back("about"); stopWords.push_back("into");
-    stopWords.push_back("over"); stopWords.push_back("after"); stopWords.push_back("this"); stopWords.push_back("that");
-    stopWords.push_back("it"); stopWords.push_back("are"); stopWords.push_back("was"); stopWords.push_back("be");
-    stopWords.push_back("has"); stopWords.push_back("have"); stopWords.push_back("will"); stopWords.push_back("as");
-    stopWords.push_back("an"); stopWords.push_back("or"); stopWords.push_back("but"); stopWords.push_back("not");
-    stopWords.push_back("no"); stopWords.push_back("we"); stopWords.push_back("our"); stopWords.push_back("us");
-    stopWords.push_back("my"); stopWords.push_back("i"); stopWords.push_back("you"); stopWords.push_back("your");
-    stopWords.push_back("he"); stopWords.push_back("she"); stopWords.push_back("they"); stopWords.push_back("their");
-    stopWords.push_back("his"); stopWords.push_back("her"); stopWords.push_back("rt"); stopWords.push_back("amp");
-
-    cout << "Building political term list from tweets..." << endl;
+// Dumps to the --metrics-out file (appending, so signal dumps accumulate) or stderr
+void dumpMetricsToTarget() {
+    if (metricsPath.empty()) {
+        dumpMetrics(cerr);
+        return;
+    }
+    ofstream file(metricsPath, ios::app);
+    dumpMetrics(file);
+}
 
-    for (const auto& row : tweets) {
-        if (row.size() < 5) continue;
-        string party = getParty(row[3]);
-        string text = row[4];
-        
-        stringstream ss(text);
-        string word;
-        while (ss >> word) {
-            string cleanWord = "";
-            for (char c : word) {
-                if (isalpha(c)) cleanWord += tolower(c);
-            }
-            if (cleanWord.length() < 3) continue; 
+extern "C" void requestMetricsDump(int) {
+    metricsDumpRequested = 1;
+}
 
-            bool isStop = false;
-            for (const string& sw : stopWords) {
-                if (cleanWord == sw) {
-                    isStop = true;
-                    break;
-                }
-            }
-            if (isStop) continue;
+void recordMetricTimer(MetricTimer timer, chrono::steady_clock::time_point start) {
+    long long nanos = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    metricTimerNanos[timer].fetch_add(nanos, memory_order_relaxed);
+    metricTimerCalls[timer].fetch_add(1, memory_order_relaxed);
+    if (metricsDumpRequested) {
+        metricsDumpRequested = 0;
+        dumpMetricsToTarget();
+    }
+}
 
-            int index = -1;
-            for (size_t i = 0; i < vocab.size(); ++i) {
-                if (vocab[i] == cleanWord) {
-                    index = i;
-                    break;
-                }
-            }
+bool configureMetrics(string format, string path) {
+    if (!format.empty() && format != "json" && format != "prometheus") {
+        cerr << "Error: --metrics expects json or prometheus" << endl;
+        return false;
+    }
+    metricsPrometheus = (format == "prometheus");
+    metricsPath = path;
+    atexit(dumpMetricsToTarget);
+#ifdef SIGUSR1
+    signal(SIGUSR1, requestMetricsDump);
+#endif
+    return true;
+}
+#else
+bool configureMetrics(string format, string path) {
+    cerr << "Warning: metrics were not compiled in (build with -DTWEET_METRICS); ignoring --metrics "
+         << format << (path.empty() ? "" : " --metrics-out " + path) << endl;
+    return true;
+}
+#endif
 
-            if (index == -1) {
-                vocab.push_back(cleanWord);
-                repCounts.push_back(0);
-                demCounts.push_back(0);
-                index = vocab.size() - 1;
-            }
+// ---------------------------------------------------------------------------
+// Metadata reports
+//
+// Reports over the senator and timestamp columns only. When the run plan
+// contains nothing else the CSV loader is given a projection without the
+// text column, so these run at close to the speed of reading the file.
+// ---------------------------------------------------------------------------
 
-            if (party == "Republican") {
-                repCounts[index]++;
-            } else {
-                demCounts[index]++;
-            }
-        }
+// Tweets per senator
+void reportTweetCounts(const vector<vector<string>>& tweets, const vector<string>& senators, ostream& out, ReportFormat format) {
+    vector<long long> counts(senators.size(), 0);
+    for (const auto& row : tweets) {
+        size_t s = lower_bound(senators.begin(), senators.end(), row[3]) - senators.begin();
+        if (s < senators.size() && senators[s] == row[3]) counts[s]++;
     }
 
-    // 2. Identify Key Terms
-    vector<string> keyTerms;
-    vector<string> keyTermParty; 
-    
-    // Find top Republican words
-    for (int k = 0; k < 15; ++k) {
-        int maxDiff = -1;
-        int bestIdx = -1;
-        for (size_t i = 0; i < vocab.size(); ++i) {
-            int diff = repCounts[i] - demCounts[i];
-            bool picked = false;
-            for(const string& s : keyTerms) if(s == vocab[i]) picked = true;
-            
-            if (!picked && diff > maxDiff && (repCounts[i] + demCounts[i] > 5)) {
-                maxDiff = diff;
-                bestIdx = i;
-            }
-        }
-        if (bestIdx != -1) {
-            keyTerms.push_back(vocab[bestIdx]);
-            keyTermParty.push_back("Republican");
+    vector<vector<string>> records;
+    if (format == REPORT_TABLE) {
+        out << "--- Tweet Counts ---" << '\n';
+        out << left << setw(20) << "Senator" << setw(15) << "Party" << right << setw(10) << "Tweets" << '\n';
+        out << string(45, '-') << '\n';
+    }
+    for (size_t s = 0; s < senators.size(); ++s) {
+        if (format == REPORT_TABLE) {
+            out << left << setw(20) << senators[s] << setw(15) << getParty(senators[s]) << right << setw(10) << counts[s] << '\n';
         }
+        records.push_back({senators[s], getParty(senators[s]), to_string(counts[s])});
+    }
+    if (format == REPORT_TABLE) {
+        out << '\n';
+    } else {
+        writeReportSection(out, format, "counts", {"senator", "party", "tweets"}, "ssi", records);
     }
+}
 
-    // Find top Democrat words
-    for (int k = 0; k < 15; ++k) {
-        int maxDiff = -1;
-        int bestIdx = -1;
-        for (size_t i = 0; i < vocab.size(); ++i) {
-            int diff = demCounts[i] - repCounts[i]; 
-            bool picked = false;
-            for(const string& s : keyTerms) if(s == vocab[i]) picked = true;
+// Tweets per calendar month (YYYY-MM of created_at)
+void reportDateHistogram(const vector<vector<string>>& tweets, ostream& out, ReportFormat format) {
+    vector<string> months;
+    months.reserve(tweets.size());
+    for (const auto& row : tweets) {
+        if (row[2].size() >= 7) months.push_back(row[2].substr(0, 7));
+    }
+    sort(months.begin(), months.end());
 
-            if (!picked && diff > maxDiff && (repCounts[i] + demCounts[i] > 5)) {
-                maxDiff = diff;
-                bestIdx = i;
-            }
-        }
-        if (bestIdx != -1) {
-            keyTerms.push_back(vocab[bestIdx]);
-            keyTermParty.push_back("Democrat");
-        }
+    vector<vector<string>> records;
+    if (format == REPORT_TABLE) {
+        out << "--- Tweets per Month ---" << '\n';
+        out << left << setw(10) << "Month" << right << setw(10) << "Tweets" << '\n';
+        out << string(20, '-') << '\n';
+    }
+    for (size_t i = 0; i < months.size();) {
+        size_t j = i;
+        while (j < months.size() && months[j] == months[i]) j++;
+        if (format == REPORT_TABLE) out << left << setw(10) << months[i] << right << setw(10) << (j - i) << '\n';
+        records.push_back({months[i], to_string(j - i)});
+        i = j;
+    }
+    if (format == REPORT_TABLE) {
+        out << '\n';
+    } else {
+        writeReportSection(out, format, "dates", {"month", "tweets"}, "si", records);
     }
+}
 
-    cout << "Identified Key Political Terms:" << endl;
-    for(size_t i=0; i<keyTerms.size(); ++i) {
-        cout << left << setw(20) << keyTerms[i] << keyTermParty[i] << endl;
+// Sorted senator names with their party
+void reportSenatorList(const vector<string>& senators, ostream& out, ReportFormat format) {
+    vector<vector<string>> records;
+    if (format == REPORT_TABLE) out << "--- Senators ---" << '\n';
+    for (const string& senator : senators) {
+        if (format == REPORT_TABLE) out << left << setw(20) << senator << getParty(senator) << '\n';
+        records.push_back({senator, getParty(senator)});
     }
-    cout << endl;
+    if (format == REPORT_TABLE) {
+        out << '\n';
+    } else {
+        writeReportSection(out, format, "senators", {"senator", "party"}, "ss", records);
+    }
+}
 
-    // 3. Analyze Tweets
-    cout << "Analyzing tweets for alignment..." << endl;
-    
-    int correctPredictions = 0;
-    int totalPredictions = 0;
-    
-    vector<int> senCorrect(senators.size(), 0);
-    vector<int> senTotal(senators.size(), 0);
+// ---------------------------------------------------------------------------
+// Report writer
+//
+// Reports are written into one in-memory buffer that main flushes once, so
+// output never waits on a flush per row. The table format is the original
+// human-readable layout. The other formats emit the same per-senator results
+// as named sections of typed columns (s = string, i = integer, d = decimal):
+//   csv     one header line per section, then one line per row; the first
+//           column is the section name
+//   json    JSON Lines, one object per row with a "section" key
+//   binary  per section: "TWRS", section name, column count, each column's
+//           type byte and name, row count, then the cells row by row
+//           (strings u32 length + bytes, integers i64, decimals IEEE double,
+//           all little endian)
+// ---------------------------------------------------------------------------
 
-    for (const auto& row : tweets) {
-        if (row.size() < 5) continue;
-        string actualParty = getParty(row[3]);
-        string text = row[4];
-        
-        vector<string> tweetWords;
-        stringstream ss(text);
-        string word;
-        while(ss >> word) {
-             string cleanWord = "";
-            for (char c : word) {
-                if (isalpha(c)) cleanWord += tolower(c);
-            }
-            tweetWords.push_back(cleanWord);
-        }
+bool parseReportFormat(const string& name, ReportFormat& format) {
+    if (name == "table") format = REPORT_TABLE;
+    else if (name == "csv") format = REPORT_CSV;
+    else if (name == "json") format = REPORT_JSON;
+    else if (name == "binary") format = REPORT_BINARY;
+    else return false;
+    return true;
+}
 
-        double score = 0;
-        int termsFound = 0;
+// Parses a --run list such as "sentiment,biden" into a RunAnalysis bit set
+bool parseRunPlan(const string& list, int& plan) {
+    plan = 0;
+    stringstream ss(list);
+    string name;
+    while (getline(ss, name, ',')) {
+        if (name == "sentiment") plan |= RUN_SENTIMENT;
+        else if (name == "talkative") plan |= RUN_TALKATIVE;
+        else if (name == "biden") plan |= RUN_BIDEN;
+        else if (name == "alignment") plan |= RUN_ALIGNMENT;
+        else if (name == "all") plan |= RUN_ALL;
+        else if (name == "counts") plan |= RUN_COUNTS;
+        else if (name == "dates") plan |= RUN_DATES;
+        else if (name == "senators") plan |= RUN_SENATORS;
+        else return false;
+    }
+    return plan != 0;
+}
 
-        for (size_t i = 0; i < tweetWords.size(); ++i) {
-            string w = tweetWords[i];
-            
-            int termIdx = -1;
-            for(size_t k=0; k<keyTerms.size(); ++k) {
-                if (keyTerms[k] == w) {
-                    termIdx = k;
-                    break;
-                }
-            }
+// Decimal text for a report cell, e.g. formatReportNumber(7.553, 2) = "7.55"
+string formatReportNumber(double value, int precision) {
+    ostringstream ss;
+    ss << fixed << setprecision(precision) << value;
+    return ss.str();
+}
 
-            if (termIdx != -1) {
-                double termVal = (keyTermParty[termIdx] == "Republican") ? 1.0 : -1.0;
-                
-                // Check negation (window +/- 2)
-                bool negated = false;
-                // int is a type cast to avoid signed/unsigned comparison warnings
-                int start = static_cast<int>(i) - 2;
-                int end = static_cast<int>(i) + 2;
-                if (start < 0) start = 0;
-                if (end >= static_cast<int>(tweetWords.size())) end = static_cast<int>(tweetWords.size()) - 1;
-
-                for (int j = start; j <= end; ++j) {
-                    if (j == static_cast<int>(i)) continue;
-                    if (tweetWords[j] == "not" || tweetWords[j] == "no" || tweetWords[j] == "never") {
-                        negated = true;
-                    }
-                }
+// Quotes a CSV cell when it contains a separator, quote or newline
+string csvCell(const string& cell) {
+    if (cell.find_first_of(",\"\n") == string::npos) return cell;
+    string quoted = "\"";
+    for (char c : cell) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
 
-                if (negated) termVal *= -1;
-                
-                score += termVal;
-                termsFound++;
-            }
+// Escapes a JSON string value
+string jsonString(const string& value) {
+    string escaped = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            const char* hex = "0123456789abcdef";
+            escaped += "\\u00";
+            escaped += hex[(c >> 4) & 0xF];
+            escaped += hex[c & 0xF];
+        } else {
+            escaped += c;
         }
+    }
+    return escaped + "\"";
+}
 
-        if (termsFound > 0) {
-            string predicted = (score > 0) ? "Republican" : (score < 0) ? "Democrat" : "Neutral";
-            if (predicted != "Neutral") {
-                totalPredictions++;
-                if (predicted == actualParty) correctPredictions++;
-                
-                // Update senator stats
-                for(size_t s=0; s<senators.size(); ++s) {
-                    if (senators[s] == row[3]) {
-                        senTotal[s]++;
-                        if (predicted == actualParty) senCorrect[s]++;
-                        break;
-                    }
+void writeReportSection(ostream& out, ReportFormat format, const string& section, const vector<string>& columns,
+                        const string& types, const vector<vector<string>>& rows) {
+    string buf;
+    if (format == REPORT_CSV) {
+        buf += "section";
+        for (const string& column : columns) buf += "," + csvCell(column);
+        buf += '\n';
+        for (const auto& row : rows) {
+            buf += csvCell(section);
+            for (const string& cell : row) buf += "," + csvCell(cell);
+            buf += '\n';
+        }
+    } else if (format == REPORT_JSON) {
+        for (const auto& row : rows) {
+            buf += "{\"section\":" + jsonString(section);
+            for (size_t c = 0; c < columns.size(); ++c) {
+                buf += "," + jsonString(columns[c]) + ":" + (types[c] == 's' ? jsonString(row[c]) : row[c]);
+            }
+            buf += "}\n";
+        }
+    } else if (format == REPORT_BINARY) {
+        buf += "TWRS";
+        appendU32(buf, static_cast<unsigned int>(section.size()));
+        buf += section;
+        appendU32(buf, static_cast<unsigned int>(columns.size()));
+        for (size_t c = 0; c < columns.size(); ++c) {
+            buf += types[c];
+            appendU32(buf, static_cast<unsigned int>(columns[c].size()));
+            buf += columns[c];
+        }
+        appendU64(buf, rows.size());
+        for (const auto& row : rows) {
+            for (size_t c = 0; c < columns.size(); ++c) {
+                if (types[c] == 'i') {
+                    appendU64(buf, static_cast<unsigned long long>(atoll(row[c].c_str())));
+                } else if (types[c] == 'd') {
+                    double value = atof(row[c].c_str());
+                    unsigned long long bits = 0;
+                    memcpy(&bits, &value, sizeof(bits));
+                    appendU64(buf, bits);
+                } else {
+                    appendU32(buf, static_cast<unsigned int>(row[c].size()));
+                    buf += row[c];
                 }
             }
         }
     }
-
-    cout << "Alignment Analysis Results by Senator:" << endl;
-    cout << left << setw(20) << "Senator" << setw(15) << "Party" << setw(15) << "Accuracy" << endl;
-    cout << string(50, '-') << endl;
-    
-    for(size_t s=0; s<senators.size(); ++s) {
-        double acc = (senTotal[s] > 0) ? static_cast<double>(senCorrect[s]) / senTotal[s] * 100.0 : 0.0;
-        cout << left << setw(20) << senators[s] << setw(15) << getParty(senators[s]) << fixed << setprecision(1) << acc << "% (" << senCorrect[s] << "/" << senTotal[s] << ")" << endl;
-    }
-    cout << endl;
-    
-    cout << "Overall Accuracy: " << (totalPredictions > 0 ? static_cast<double>(correctPredictions) / totalPredictions * 100.0 : 0.0) << "%" << endl;
+    out.write(buf.data(), static_cast<streamsize>(buf.size()));
 }
 
 /*
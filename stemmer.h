@@ -54,8 +54,9 @@
    should be done before stem(...) is called.
 */
 
-static char * b;       /* buffer for word to be stemmed */
-static int k,k0,j;     /* j is a general offset into the string */
+/* Per thread, so words can be stemmed on several threads at once */
+static thread_local char * b;       /* buffer for word to be stemmed */
+static thread_local int k,k0,j;     /* j is a general offset into the string */
 
 /* cons(i) is TRUE <=> b[i] is a consonant. */
 
@@ -380,20 +381,16 @@ static void stemfile(FILE * f)
 }
 
 static std::string stemString(std::string word)
-{    size_t i;
-    //std::cout << word << " " << word.size() << std::endl;
-    s = (char *) malloc(i_max+1);
-    for(i = 0; i < word.size(); i++)
-    {
-        s[i] = tolower(word[i]);
-        //std::cout << word[i] ;
-    }
-    //std::cout << "\n" ;
-    s[stem(s,0,i-1)+1] = 0;
-    //std::cout << s << std::endl;
-    std::string new_word = s;
-    return new_word;
-    
+{   /* stems in the word's own storage: no shared buffer to leak or
+       overflow, and bytes are widened before tolower so UTF-8 input is
+       well defined. The spare byte stands in for the terminator the old
+       buffer had past the word. */
+    size_t n = word.size();
+    if (n == 0) return word;
+    for (size_t i = 0; i < n; i++) word[i] = tolower((unsigned char) word[i]);
+    word.push_back('\0');
+    word.resize(stem(&word[0], 0, (int) n - 1) + 1);
+    return word;
 }
 /*
 int main(int argc, char * argv[])